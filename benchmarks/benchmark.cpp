@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "perfevent/PerfEvent.hpp"
+#include "pytotune/algorithms/fft.h"
 #include "pytotune/algorithms/pitch_correction_pipeline.h"
 
 constexpr auto pitchRange = p2t::VoiceRanges::HUMAN;
@@ -52,7 +55,7 @@ int main(int argc, char *argv[]) {
     }
 
     if (argc <= 1) {
-        std::cerr << "Please specify a benchmark to run: 'detection', 'correction', or 'pipeline'" << std::endl;
+        std::cerr << "Please specify a benchmark to run: 'detection', 'detection_methods', 'correction', 'pipeline', 'fft', 'fft_large' or 'fft_pruned'" << std::endl;
         return 1;
     }
 
@@ -75,6 +78,57 @@ int main(int argc, char *argv[]) {
             if (decimation > 1) e.printHeader = false;
             pipeline.detectPitch(wav, windowing, pitchRange, 0.05f, decimation);
         }
+
+        // Coarse candidates on the decimated signal, refined at the full rate
+        for (int decimation : {2, 4, 8}) {
+            PerfEventBlock b(e, 1000000, "coarse_to_fine_d" + std::to_string(decimation) + std::string(HWY_TAG));
+            pipeline.detectPitch(wav, windowing, pitchRange, 0.05f, decimation, p2t::DifferenceMethod::Auto,
+                                 p2t::SearchMode::CoarseToFine);
+        }
+
+        // Tau range cut off above the previous window's period
+        for (int decimation : {1, 2, 4, 8}) {
+            PerfEventBlock b(e, 1000000, "tracking_d" + std::to_string(decimation) + std::string(HWY_TAG));
+            pipeline.detectPitch(wav, windowing, pitchRange, 0.05f, decimation, p2t::DifferenceMethod::Auto,
+                                 p2t::SearchMode::Tracking);
+        }
+
+        // The decimation step alone, single lowpass against the half-band cascade Auto picks for these factors
+        const std::pair<const char *, p2t::DecimationMethod> decimationMethods[] = {
+            {"zero_phase", p2t::DecimationMethod::ZeroPhase}, {"halfband_cascade", p2t::DecimationMethod::HalfbandCascade}
+        };
+        for (int decimation : {2, 4, 8}) {
+            for (const auto &[methodName, method] : decimationMethods) {
+                PerfEventBlock b(e, 1000000, "decimate_d=" + std::to_string(decimation) + "_m=" + methodName +
+                                             std::string(HWY_TAG));
+                [[maybe_unused]] const auto decimated =
+                        p2t::YINPitchDetector::decimate(wav.data().samples, decimation, method);
+            }
+        }
+        return 0;
+    }
+    if (tag == "detection_methods") {
+        // Difference function methods on the default range and on the widest one, where Fft pays off most
+        p2t::WavFile wav = p2t::WavFile::load(mode == "scale" ? wavPathScale : wavPathMidi);
+        p2t::PitchCorrectionPipeline pipeline;
+        const std::pair<const char *, p2t::DifferenceMethod> methods[] = {
+            {"direct", p2t::DifferenceMethod::Direct}, {"fft", p2t::DifferenceMethod::Fft},
+            {"incremental", p2t::DifferenceMethod::Incremental}, {"auto", p2t::DifferenceMethod::Auto}
+        };
+        const std::pair<const char *, p2t::PitchRange> ranges[] = {
+            {"human", p2t::VoiceRanges::HUMAN}, {"piano", p2t::VoiceRanges::PIANO}
+        };
+
+        for (const auto &[rangeName, range] : ranges) {
+            for (int decimation : {1, 2, 4, 8}) {
+                for (const auto &[methodName, method] : methods) {
+                    PerfEventBlock b(e, 1000000, "det_" + mode + "_range=" + rangeName + "_d=" +
+                                                 std::to_string(decimation) + "_m=" + methodName +
+                                                 std::string(HWY_TAG));
+                    pipeline.detectPitch(wav, windowing, range, 0.05f, decimation, method);
+                }
+            }
+        }
         return 0;
     }
     if (tag == "correction") {
@@ -156,6 +210,99 @@ int main(int argc, char *argv[]) {
         }
         return 0;
     }
-    std::cerr << "Unknown benchmark: " << tag << ". Please specify 'detection', 'correction', 'pipeline_ranges', or 'pipeline_windows' and mode must be 'midi' or 'scale'" << std::endl;
+    if (tag == "fft") {
+        // Same transform sizes as the pipeline_windows sweep, scale = number of transforms
+        const int fftSizes[] = { 128, 256, 512, 1024, 2048, 4096, 8192 };
+        const p2t::FftKernel kernels[] = {
+            p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::Radix4, p2t::FftKernel::Stockham,
+            p2t::FftKernel::FixedSize
+        };
+
+        for (int n : fftSizes) {
+            const int repetitions = (1 << 24) / n;
+            std::vector<float> input(2 * n);
+            for (int i = 0; i < 2 * n; ++i) input[i] = std::sin(0.01f * static_cast<float>(i));
+            std::vector<float> buffer(2 * n);
+
+            for (const auto kernel : kernels) {
+                const p2t::FftPlan plan(n, kernel);
+                PerfEventBlock b(e, repetitions, "fft_n=" + std::to_string(n) + "_k=" + p2t::fftKernelName(kernel) +
+                                                 std::string(HWY_TAG));
+                for (int r = 0; r < repetitions; ++r) {
+                    // restore the input so repeated forward transforms cannot overflow
+                    std::copy(input.begin(), input.end(), buffer.begin());
+                    plan.execute(buffer.data(), -1);
+                }
+            }
+            e.printHeader = false;
+        }
+        return 0;
+    }
+    if (tag == "fft_large") {
+        // Sizes past the L2 cache to find where the four-step kernel overtakes the streaming kernels
+        const p2t::FftKernel kernels[] = {
+            p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::Stockham, p2t::FftKernel::FourStep
+        };
+        const std::string ompTag = (std::getenv("OMP_NUM_THREADS") && std::string(std::getenv("OMP_NUM_THREADS")) ==
+                                                                          "1")
+                                       ? "_omp=off"
+                                       : "_omp=on";
+
+        for (int n = 1 << 12; n <= 1 << 22; n <<= 1) {
+            const int repetitions = std::max((1 << 24) / n, 4);
+            std::vector<float> input(2 * static_cast<size_t>(n));
+            for (size_t i = 0; i < input.size(); ++i) input[i] = std::sin(0.01f * static_cast<float>(i));
+            std::vector<float> buffer(input.size());
+
+            for (const auto kernel : kernels) {
+                for (const bool parallel : {false, true}) {
+                    // Parallel plans replace the other kernels by FourStep, which is already measured
+                    if (parallel && kernel != p2t::FftKernel::Radix2 && kernel != p2t::FftKernel::FourStep) continue;
+
+                    const p2t::FftPlan plan(n, kernel, parallel);
+                    PerfEventBlock b(e, repetitions, "fft_n=" + std::to_string(n) + "_k=" +
+                                                     p2t::fftKernelName(kernel) + (parallel ? "_par" + ompTag : "") +
+                                                     std::string(HWY_TAG));
+                    for (int r = 0; r < repetitions; ++r) {
+                        std::copy(input.begin(), input.end(), buffer.begin());
+                        plan.execute(buffer.data(), -1);
+                    }
+                }
+            }
+            e.printHeader = false;
+        }
+        return 0;
+    }
+    if (tag == "fft_pruned") {
+        // Zero padding by 2 and 4 as used for linear correlation, and the half or quarter of the bins
+        // a caller reads, against the full transform of the same plan
+        const int fftSizes[] = { 1024, 2048, 4096, 8192 };
+        const int ratios[] = { 1, 2, 4 };
+
+        for (int n : fftSizes) {
+            const int repetitions = (1 << 24) / n;
+            const p2t::FftPlan plan(n);
+            std::vector<float> buffer(2 * n);
+
+            for (int inputRatio : ratios) {
+                for (int outputRatio : ratios) {
+                    const int inputs = n / inputRatio;
+                    std::vector<float> input(2 * n, 0.f);
+                    for (int i = 0; i < 2 * inputs; ++i) input[i] = std::sin(0.01f * static_cast<float>(i));
+
+                    PerfEventBlock b(e, repetitions, "fft_pruned_n=" + std::to_string(n) + "_in=1/" +
+                                                     std::to_string(inputRatio) + "_out=1/" +
+                                                     std::to_string(outputRatio) + std::string(HWY_TAG));
+                    for (int r = 0; r < repetitions; ++r) {
+                        std::copy(input.begin(), input.end(), buffer.begin());
+                        plan.executePruned(buffer.data(), -1, inputs, n / outputRatio);
+                    }
+                }
+            }
+            e.printHeader = false;
+        }
+        return 0;
+    }
+    std::cerr << "Unknown benchmark: " << tag << ". Please specify 'detection', 'detection_methods', 'correction', 'pipeline_ranges', 'pipeline_windows', 'fft', 'fft_large' or 'fft_pruned' and mode must be 'midi' or 'scale'" << std::endl;
     return 1;
 }
@@ -0,0 +1,17 @@
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+RESULTS="$SCRIPT_DIR/results_fft_kernels.csv"
+
+pushd ../cmake-build-relwithdebinfo
+
+> "$RESULTS"  # truncate
+
+print_header=true
+for hwy in ON OFF; do
+    cmake . -DPYTOTUNE_USE_HWY=$hwy -Wno-dev > /dev/null 2>&1
+    cmake --build . --target pytotune_fft_benchmarks -j 10 > /dev/null 2>&1
+
+    ./pytotune_fft_benchmarks $( [ "$print_header" = "false" ] && echo false ) | tee -a "$RESULTS"
+    print_header=false
+done
+
+popd
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "perfevent/PerfEvent.hpp"
+#include "pytotune/algorithms/fft.h"
+#include "../tests/reference/pitch_shifter_reference.h"
+
+// Throughput and accuracy of every FFT kernel, with the original smbFft as a baseline.
+//
+// Per size and kernel one CSV line: ns per transform, GFLOP/s by the usual 5 N log2 N
+// convention, and the error of a forward transform of uniform noise against a
+// double-precision DFT, relative to the RMS of the exact spectrum (max_err for the worst
+// component, rms_err over all of them).
+
+#if USE_HWY
+constexpr std::string_view HWY_TAG = "_hwy=on";
+#else
+constexpr std::string_view HWY_TAG = "_hwy=off";
+#endif
+
+// Powers of two cover the phase vocoder and the window sweeps, the others MixedRadix and Bluestein
+constexpr int fftSizes[] = {64, 128, 256, 512, 1000, 1009, 1024, 2048, 4096, 8192, 16384};
+
+constexpr p2t::FftKernel kernels[] = {
+    p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::Radix4, p2t::FftKernel::Stockham,
+    p2t::FftKernel::MixedRadix, p2t::FftKernel::Bluestein, p2t::FftKernel::FixedSize, p2t::FftKernel::FourStep
+};
+
+PerfEvent e;
+
+namespace {
+    /// Forward DFT in double precision, with W^(jk) taken from a table so no angle loses precision.
+    std::vector<double> exactDft(const std::vector<float> &input, const int n) {
+        std::vector<double> cosTable(n), sinTable(n);
+        for (int t = 0; t < n; ++t) {
+            cosTable[t] = std::cos(2.0 * M_PI * t / n);
+            sinTable[t] = -std::sin(2.0 * M_PI * t / n);
+        }
+
+        std::vector<double> spectrum(2 * static_cast<size_t>(n));
+        for (int k = 0; k < n; ++k) {
+            double re = 0.0, im = 0.0;
+            for (int j = 0, t = 0; j < n; ++j, t = (t + k) % n) {
+                re += input[2 * j] * cosTable[t] - input[2 * j + 1] * sinTable[t];
+                im += input[2 * j] * sinTable[t] + input[2 * j + 1] * cosTable[t];
+            }
+            spectrum[2 * k] = re;
+            spectrum[2 * k + 1] = im;
+        }
+        return spectrum;
+    }
+
+    struct Accuracy {
+        double maxError;
+        double rmsError;
+    };
+
+    template<typename Transform>
+    Accuracy measureAccuracy(const std::vector<float> &input, const std::vector<double> &exact, Transform transform) {
+        std::vector<float> buffer = input;
+        transform(buffer.data());
+
+        double maxError = 0.0, errorEnergy = 0.0, energy = 0.0;
+        for (size_t i = 0; i < exact.size(); i += 2) {
+            const double dr = buffer[i] - exact[i];
+            const double di = buffer[i + 1] - exact[i + 1];
+            maxError = std::max(maxError, std::sqrt(dr * dr + di * di));
+            errorEnergy += dr * dr + di * di;
+            energy += exact[i] * exact[i] + exact[i + 1] * exact[i + 1];
+        }
+        const double rms = std::sqrt(energy / static_cast<double>(exact.size() / 2));
+        return {maxError / rms, std::sqrt(errorEnergy / energy)};
+    }
+
+    /// Seconds to restore the input of one transform, subtracted from the timed loops.
+    double copySeconds(const std::vector<float> &input, std::vector<float> &buffer, const int repetitions) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            std::copy(input.begin(), input.end(), buffer.begin());
+            asm volatile("" : : "r"(buffer.data()) : "memory");
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / repetitions;
+    }
+
+    template<typename Transform>
+    void runKernel(const std::string &name, const int n, const std::vector<float> &input,
+                   const std::vector<double> &exact, Transform transform) {
+        const auto [maxError, rmsError] = measureAccuracy(input, exact, transform);
+        const int repetitions = std::max((1 << 24) / n, 16);
+        std::vector<float> buffer(input.size());
+        const double copy = copySeconds(input, buffer, repetitions);
+
+        std::ostringstream maxText, rmsText;
+        maxText << std::scientific << std::setprecision(2) << maxError;
+        rmsText << std::scientific << std::setprecision(2) << rmsError;
+
+        PerfEventBlock b(e, repetitions, "fft_n=" + std::to_string(n) + "_k=" + name + std::string(HWY_TAG));
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repetitions; ++r) {
+            // restore the input so repeated forward transforms cannot overflow
+            std::copy(input.begin(), input.end(), buffer.begin());
+            transform(buffer.data());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const double seconds = std::max(elapsed.count() / repetitions - copy, 1e-12);
+        const double flops = 5.0 * n * std::log2(static_cast<double>(n));
+        std::ostringstream nsText, gflopsText;
+        nsText << std::fixed << std::setprecision(1) << seconds * 1e9;
+        gflopsText << std::fixed << std::setprecision(2) << flops / seconds * 1e-9;
+        e.setParam("ns", nsText.str());
+        e.setParam("gflops", gflopsText.str());
+        e.setParam("max_err", maxText.str());
+        e.setParam("rms_err", rmsText.str());
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        if (std::string(argv[1]) == "true")
+            e.printHeader = true;
+        else if (std::string(argv[1]) == "false")
+            e.printHeader = false;
+        else {
+            std::cerr << "Unknown argument: " << argv[1] << ". Expected 'true' or 'false'" << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> noise(-1.f, 1.f);
+
+    for (const int n : fftSizes) {
+        std::vector<float> input(2 * static_cast<size_t>(n));
+        for (auto &x : input) x = noise(random);
+        const std::vector<double> exact = exactDft(input, n);
+
+        if ((n & (n - 1)) == 0) {
+            runKernel("reference", n, input, exact, [n](float *buffer) { smbFft(buffer, n, -1); });
+        }
+        for (const auto kernel : kernels) {
+            const p2t::FftPlan plan(n, kernel);
+            // Kernels that replaced themselves for this size are measured under their own name
+            if (plan.kernel() != kernel) continue;
+
+            runKernel(p2t::fftKernelName(kernel), n, input, exact,
+                      [&plan](float *buffer) { plan.execute(buffer, -1); });
+        }
+    }
+    return 0;
+}
@@ -1,20 +1,342 @@
 #ifndef PYTOTUNE_FFT_H
 #define PYTOTUNE_FFT_H
 
+#include <memory>
 #include <vector>
 
 namespace p2t {
+    /**
+     * Butterfly kernels an FftPlan can run. All kernels compute the same transform.
+     *
+     * Radix2, Simd, Radix4, Stockham and FourStep need a power-of-two size, FixedSize one
+     * of the sizes with a compile-time specialization (see fixed_size_fft.h) and
+     * falls back to DEFAULT_FFT_KERNEL for other powers of two. Plans of any
+     * other size use MixedRadix when the size only has the prime factors 2, 3, 5
+     * and 7, and Bluestein otherwise.
+     */
+    enum class FftKernel {
+        /// Scalar iterative radix-2 directly on the interleaved buffer.
+        Radix2,
+        /// Highway SIMD radix-2 on a split real/imaginary copy of the buffer.
+        Simd,
+        /// Scalar radix-4 (with one radix-2 stage for odd powers of two), halving the passes over the buffer.
+        Radix4,
+        /// Scalar radix-2 Stockham autosort, ping-ponging with a plan-owned buffer instead of bit-reversing.
+        Stockham,
+        /// Stockham autosort with radix 4, 2, 3, 5 and 7 stages, for sizes with only these prime factors.
+        MixedRadix,
+        /// Bluestein chirp-z: any size as a convolution computed with power-of-two FFTs.
+        Bluestein,
+        /// Compile-time specialized radix-2 Fft<N> with constexpr tables.
+        FixedSize,
+        /// Four-step: N = rows * columns as cache-resident sub-FFTs of size ~√N, for transforms larger than L2.
+        FourStep,
+        /// The kernel the planner measured fastest for the size on this CPU, DEFAULT_FFT_KERNEL without wisdom, see fft_planner.h.
+        Auto,
+    };
+
+    /// Size from which smbFft runs a single transform on all OpenMP threads.
+    constexpr int PARALLEL_FFT_MIN_SIZE = 1 << 18;
+
+#if USE_HWY
+    constexpr FftKernel DEFAULT_FFT_KERNEL = FftKernel::Simd;
+#else
+    constexpr FftKernel DEFAULT_FFT_KERNEL = FftKernel::Radix2;
+#endif
+
+    /**
+     * Get a short lowercase name of a kernel, e.g. for benchmark tags.
+     * @param kernel The kernel to name.
+     * @return Name such as "radix2".
+     */
+    const char *fftKernelName(FftKernel kernel);
+
+    /**
+     * Precomputed state for in-place complex FFTs of one fixed size.
+     *
+     * A plan owns the bit-reversal permutation and exact per-stage twiddle
+     * tables, so building it once and reusing it for every frame avoids
+     * recomputing them on each transform. Some kernels also work in a
+     * plan-owned scratch buffer, so a plan must not be executed by several
+     * threads at once; give each thread its own plan instead.
+     */
+    class FftPlan {
+    public:
+        /**
+         * Build a plan for transforms of the given size.
+         * @param fftFrameSize Number of complex samples.
+         * @param kernel Butterfly kernel used by execute(). Replaced by MixedRadix or Bluestein
+         *               if it does not support the size.
+         * @param parallel Spread every single transform over the OpenMP threads (OMP_NUM_THREADS).
+         *                 Radix2 splits the butterfly blocks of each stage and FourStep its
+         *                 sub-transforms; other power-of-two kernels are replaced by FourStep.
+         *                 Ignored for sizes that are not a power of two.
+         * @throws std::invalid_argument If the size is not positive.
+         */
+        explicit FftPlan(int fftFrameSize, FftKernel kernel = DEFAULT_FFT_KERNEL, bool parallel = false);
+
+        /**
+         * Get the number of complex samples transformed by this plan.
+         * @return Transform size.
+         */
+        [[nodiscard]] int size() const {
+            return n;
+        }
+
+        /**
+         * Get the butterfly kernel used by this plan.
+         * @return The kernel.
+         */
+        [[nodiscard]] FftKernel kernel() const {
+            return fftKernel;
+        }
+
+        /**
+         * Check whether each transform of this plan runs on all OpenMP threads.
+         * @return True for parallel plans.
+         */
+        [[nodiscard]] bool isParallel() const {
+            return parallel;
+        }
+
+        /**
+         * Perform an in-place FFT or inverse FFT on an interleaved complex buffer.
+         *
+         * The inverse transform is not scaled by 1/N.
+         *
+         * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with at least 2 * size() floats.
+         * @param sign -1 for FFT, 1 for inverse FFT
+         */
+        void execute(float *fftBuffer, int sign) const;
+
+        /**
+         * Transform several same-size frames at once.
+         *
+         * With Highway, groups of frames are transposed so that each SIMD lane holds
+         * one frame ("vertical" vectorization). Every butterfly of every stage then uses
+         * full vectors regardless of the transform size. Frames left over after the last
+         * full group fall back to execute().
+         *
+         * @param frames Pointers to count interleaved complex buffers of at least 2 * size() floats each.
+         * @param count Number of frames.
+         * @param sign -1 for FFT, 1 for inverse FFT
+         */
+        void executeBatch(float *const *frames, int count, int sign) const;
+
+        /**
+         * Perform an in-place FFT of a zero-padded buffer, or one of which only the low bins are used.
+         *
+         * Runs radix-2 stages that skip butterflies on known zeros and unused bins.
+         * With only L = nonZeroInputs leading samples non-zero, the first log2(N/L)
+         * stages merely replicate each input, so they are replaced by a broadcast.
+         * With only K = usedOutputs leading bins needed, every stage longer than K
+         * computes only the K upper butterfly outputs per block. Both combine, e.g.
+         * for 2x zero-padded correlations of which half the lags are read.
+         *
+         * FixedSize and FourStep plans of sizes with a fixed-size FFT use its stages,
+         * other power-of-two plans the stages of the Simd kernel. Plans of sizes
+         * that are not a power of two and larger FourStep plans run a full execute().
+         *
+         * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with at least 2 * size() floats.
+         * @param sign -1 for FFT, 1 for inverse FFT
+         * @param nonZeroInputs Number of leading complex samples that may be non-zero, all later ones must be
+         *                      zero. Rounded up to a power of two.
+         * @param usedOutputs Number of leading bins that must be computed, later bins are left unspecified.
+         *                    Rounded up to a power of two.
+         * @throws std::invalid_argument If a count is not positive.
+         */
+        void executePruned(float *fftBuffer, int sign, int nonZeroInputs, int usedOutputs) const;
+
+    private:
+        int n;
+        int numStages;
+        FftKernel fftKernel;
+        bool parallel;
+        /// bitReversal[i] is the bit-reversed index of complex sample i.
+        std::vector<int> bitReversal;
+        /// cos(2πk/le) and sin(2πk/le) for every stage le = 2..N, stored at offset le/2 - 1.
+        std::vector<float> twiddleCos;
+        std::vector<float> twiddleSin;
+        /// cos(2π3k/le) and sin(2π3k/le) for every radix-4 stage le = 4L, k < L, stored at offset L - 1.
+        std::vector<float> twiddle3Cos;
+        std::vector<float> twiddle3Sin;
+        /// Work area of kernels that do not operate on the interleaved buffer directly.
+        mutable std::vector<float> scratch;
+        /// Transposed frames of executeBatch(), one SIMD lane per frame.
+        mutable std::vector<float> batchScratch;
+        /// Radix of every MixedRadix stage in execution order.
+        std::vector<int> radices;
+        /// Per MixedRadix stage of length len and radix p: W_len^(j*u) for j < len/p, u = 1..p-1.
+        std::vector<float> mixedCos;
+        std::vector<float> mixedSin;
+        /// Bluestein chirp exp(-iπk²/N), interleaved.
+        std::vector<float> chirp;
+        /// Spectrum of the conjugate chirp, wrapped and zero-padded to the inner size, interleaved.
+        std::vector<float> chirpSpectrum;
+        /// Power-of-two plan computing the Bluestein convolution.
+        std::unique_ptr<FftPlan> innerPlan;
+        /// FourStep view of the buffer as fourStepRows x fourStepColumns, with one plan per dimension.
+        int fourStepRows = 0;
+        int fourStepColumns = 0;
+        /// FourStep sub-plans and gathered column tiles, one per thread executing them.
+        mutable std::vector<std::unique_ptr<FftPlan> > rowPlans;
+        mutable std::vector<std::unique_ptr<FftPlan> > columnPlans;
+        mutable std::vector<float> tileScratch;
+        /// Split real and imaginary parts of executePruned(), allocated on first use.
+        mutable std::vector<float> prunedScratch;
+        /// W_N^(r*c) for row r and column c, stored at c * fourStepRows + r.
+        std::vector<float> fourStepCos;
+        std::vector<float> fourStepSin;
+
+        void executeRadix2(float *fftBuffer, int sign) const;
+
+        void executeRadix2Parallel(float *fftBuffer, int sign) const;
+
+        void executeSimd(float *fftBuffer, int sign) const;
+
+        void executeRadix4(float *fftBuffer, int sign) const;
+
+        void executeStockham(float *fftBuffer, int sign) const;
+
+        void executeMixedRadix(float *fftBuffer, int sign) const;
+
+        void executeBluestein(float *fftBuffer, int sign) const;
+
+        void executeFourStep(float *fftBuffer, int sign) const;
+
+        void bitReverse(float *fftBuffer) const;
+    };
+
+    /**
+     * Precomputed state for in-place FFTs of real-valued signals.
+     *
+     * The N real samples are packed as N/2 complex values, transformed with a
+     * half-size complex FFT and untangled with a post-twiddle pass, so only the
+     * non-negative frequency bins 0..N/2 are ever computed or stored. N can be
+     * any even size.
+     */
+    class RealFftPlan {
+    public:
+        /**
+         * Build a plan for real transforms of the given size.
+         * @param fftFrameSize Number of real samples (must be even and at least 2).
+         * @param kernel Butterfly kernel of the underlying half-size complex FFT.
+         * @throws std::invalid_argument If the size is not supported.
+         */
+        explicit RealFftPlan(int fftFrameSize, FftKernel kernel = DEFAULT_FFT_KERNEL);
+
+        /**
+         * Get the number of real samples transformed by this plan.
+         * @return Transform size.
+         */
+        [[nodiscard]] int size() const {
+            return n;
+        }
+
+        /**
+         * Real-to-complex FFT in place.
+         * @param buffer Holds size() real samples on input and the size() / 2 + 1 interleaved
+         *               bins [Re0, Im0, ..., ReN/2, ImN/2] on output; must have room for size() + 2 floats.
+         */
+        void forward(float *buffer) const;
+
+        /**
+         * Complex-to-real inverse FFT in place, the exact inverse of forward() up to a factor of size().
+         *
+         * The spectrum is treated as Hermitian, so the imaginary parts of the DC and Nyquist
+         * bins are ignored.
+         *
+         * @param buffer Holds size() / 2 + 1 interleaved bins on input and size() real samples on output.
+         */
+        void inverse(float *buffer) const;
+
+        /**
+         * Real-to-complex FFT in place of a zero-padded signal, see forward() and FftPlan::executePruned().
+         * @param buffer As for forward().
+         * @param nonZeroInputs Number of leading samples that may be non-zero, all later ones must be zero.
+         */
+        void forwardPruned(float *buffer, int nonZeroInputs) const;
+
+        /**
+         * Complex-to-real inverse FFT in place of which only the leading samples are used,
+         * see inverse() and FftPlan::executePruned().
+         * @param buffer As for inverse(); samples from usedOutputs rounded up to the pruning granularity
+         *               on are left unspecified.
+         * @param usedOutputs Number of leading samples that must be computed.
+         */
+        void inversePruned(float *buffer, int usedOutputs) const;
+
+        /**
+         * Real-to-complex FFT of several frames at once, see forward() and FftPlan::executeBatch().
+         * @param frames Pointers to count buffers of size() + 2 floats each.
+         * @param count Number of frames.
+         */
+        void forwardBatch(float *const *frames, int count) const;
+
+        /**
+         * Complex-to-real inverse FFT of several frames at once, see inverse() and FftPlan::executeBatch().
+         * @param frames Pointers to count buffers of size() + 2 floats each.
+         * @param count Number of frames.
+         */
+        void inverseBatch(float *const *frames, int count) const;
+
+    private:
+        int n;
+        FftPlan halfPlan;
+
+        void splitSpectrum(float *buffer) const;
+
+        void mergeSpectrum(float *buffer) const;
+        /// cos(2πk/N) and sin(2πk/N) for k = 0..N/4 used to split the packed half-size spectrum.
+        std::vector<float> twiddleCos;
+        std::vector<float> twiddleSin;
+    };
+
+    /**
+     * Select the kernel of the plans smbFft builds from now on.
+     *
+     * Defaults to Auto, so sizes tuned with tuneFft() use the kernel measured
+     * fastest on this CPU and all others DEFAULT_FFT_KERNEL. With FixedSize, the sizes with a compile-time
+     * specialization run it directly without a plan lookup.
+     *
+     * @param kernel Butterfly kernel to use.
+     */
+    void setSmbFftKernel(FftKernel kernel);
+
+    /**
+     * Get the kernel currently used by smbFft.
+     * @return The kernel.
+     */
+    FftKernel getSmbFftKernel();
+
     /**
      * Performs an in-place FFT or inverse FFT on a complex buffer.
      *
      * The fftBuffer is a vector of floats where real and imaginary parts are
-     * interleaved: [Re0, Im0, Re1, Im1, ...].
+     * interleaved: [Re0, Im0, Re1, Im1, ...]. Sizes with a compile-time
+     * specialized Fft<N> dispatch to it while the kernel is FixedSize. Otherwise
+     * a plan for each size and kernel (see setSmbFftKernel) is built on first
+     * use and cached per thread. From PARALLEL_FFT_MIN_SIZE on, the plan runs
+     * each transform on all OpenMP threads.
      *
      * @param fftBuffer The interleaved complex buffer to transform
-     * @param fftFrameSize Number of complex samples (must be a power of 2)
+     * @param fftFrameSize Number of complex samples
      * @param sign -1 for FFT, 1 for inverse FFT
      */
     void smbFft(std::vector<float> &fftBuffer, int fftFrameSize, int sign);
+
+    /**
+     * Performs in-place FFTs or inverse FFTs on several same-size complex buffers at once.
+     *
+     * Like smbFft, but the frames are transformed together with SIMD lanes spanning
+     * frames, so short transforms also use full vectors.
+     *
+     * @param frames The first of count consecutive interleaved complex buffers
+     * @param count Number of buffers to transform
+     * @param fftFrameSize Number of complex samples per buffer
+     * @param sign -1 for FFT, 1 for inverse FFT
+     */
+    void fftBatch(std::vector<float> *frames, int count, int fftFrameSize, int sign);
 }
 
 #endif //PYTOTUNE_FFT_H
@@ -0,0 +1,68 @@
+#ifndef PYTOTUNE_FFT_PLANNER_H
+#define PYTOTUNE_FFT_PLANNER_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "pytotune/algorithms/fft.h"
+
+namespace p2t {
+    /**
+     * Environment variable naming the wisdom file. Setting it also lets FftKernel::Auto
+     * measure sizes without wisdom on first use. Set it to an empty string to keep
+     * the measured wisdom in memory only.
+     */
+    constexpr const char *FFT_WISDOM_ENV = "PYTOTUNE_FFT_WISDOM";
+
+    /**
+     * Get the fastest kernel for a size on this CPU, as used by FftKernel::Auto.
+     *
+     * Known sizes are answered from the wisdom loaded from the wisdom file.
+     * Unknown sizes get DEFAULT_FFT_KERNEL, which plans replace by MixedRadix
+     * where it does not support the size. Only if PYTOTUNE_FFT_WISDOM is set
+     * are unknown sizes measured on first use by timing every kernel that
+     * supports the size, and the winner is added to the wisdom file.
+     * Thread-safe; concurrent callers wait for a running measurement.
+     *
+     * @param n Number of complex samples.
+     * @return The planned kernel, never FftKernel::Auto.
+     */
+    FftKernel plannedFftKernel(int n);
+
+    /**
+     * Measure the kernels for the given sizes now, replacing existing wisdom for them,
+     * and store the winners in the wisdom file.
+     * Entries other processes wrote to the file in the meantime are kept.
+     * @param sizes Complex transform sizes, by default the powers of two from 64 to 8192
+     *              used by the phase vocoder and the window sweeps.
+     * @throws std::runtime_error if the wisdom file cannot be written.
+     */
+    void tuneFft(const std::vector<int> &sizes = {64, 128, 256, 512, 1024, 2048, 4096, 8192});
+
+    /**
+     * Get the kernel recorded for a size without measuring anything.
+     * @param n Number of complex samples.
+     * @return The recorded kernel, or nothing if the size has not been planned on this CPU.
+     */
+    std::optional<FftKernel> fftWisdom(int n);
+
+    /**
+     * Select the wisdom file. The in-memory wisdom is replaced by the entries of the new file.
+     *
+     * Without a call, the file named by PYTOTUNE_FFT_WISDOM is used, otherwise
+     * ~/.pytotune_fft_wisdom. Entries are tagged with the CPU model, so one file
+     * can be shared by machines with different CPUs.
+     *
+     * @param path Wisdom file, or an empty string to keep wisdom in memory only.
+     */
+    void setFftWisdomPath(const std::string &path);
+
+    /**
+     * Get the wisdom file currently in use.
+     * @return Path of the file, empty if wisdom is kept in memory only.
+     */
+    std::string getFftWisdomPath();
+}
+
+#endif //PYTOTUNE_FFT_PLANNER_H
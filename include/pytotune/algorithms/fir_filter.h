@@ -0,0 +1,111 @@
+#ifndef PYTOTUNE_FIR_FILTER_H
+#define PYTOTUNE_FIR_FILTER_H
+
+#include <vector>
+
+namespace p2t {
+    /// Evaluation of a FIR filter, see FirFilter.
+    enum class FirMethod {
+        /// SIMD dot products in the time domain, O(taps) per output sample.
+        Direct,
+        /// Block overlap-save with real FFTs and precomputed kernel spectra, O(log(fftSize)) per output sample.
+        OverlapSave,
+        /// Direct below FIR_OVERLAP_SAVE_MIN_TAPS non-zero taps per polyphase branch on average,
+        /// OverlapSave from there on.
+        Auto
+    };
+
+    /// Non-zero taps per polyphase branch from which FirMethod::Auto switches to overlap-save.
+    constexpr int FIR_OVERLAP_SAVE_MIN_TAPS = 24;
+
+    /**
+     * FIR filter with optional decimation.
+     *
+     * Only the retained output samples are evaluated: the kernel is split into
+     * decimationFactor polyphase branches, each a plain FIR running at the output
+     * rate on one phase of the input. The branches are evaluated with SIMD dot
+     * products over their non-zero taps for short or sparse kernels such as
+     * half-band filters, or by overlap-save with real FFTs for long ones; the
+     * branch spectra are computed once at construction.
+     *
+     * apply() is const and may be called from several threads at once.
+     */
+    class FirFilter {
+    public:
+        /**
+         * Construct a filter.
+         * @param kernel Impulse response, kernel[0] applied to the newest input sample.
+         * @param decimationFactor Keep every decimationFactor-th output sample, 1 to keep all of them.
+         * @param method Evaluation of the filter; Auto chooses by the number of non-zero taps per branch.
+         * @throws std::invalid_argument If the kernel is empty or the decimation factor is below 1.
+         */
+        explicit FirFilter(std::vector<float> kernel, int decimationFactor = 1, FirMethod method = FirMethod::Auto);
+
+        /**
+         * Get the number of taps of the kernel.
+         * @return Kernel size.
+         */
+        [[nodiscard]] int taps() const {
+            return static_cast<int>(kernel.size());
+        }
+
+        /**
+         * Get the decimation factor.
+         * @return Distance in input samples between two output samples.
+         */
+        [[nodiscard]] int decimationFactor() const {
+            return factor;
+        }
+
+        /**
+         * Get the evaluation method in use.
+         * @return Direct or OverlapSave, never Auto.
+         */
+        [[nodiscard]] FirMethod method() const {
+            return firMethod;
+        }
+
+        /**
+         * Get the size of the overlap-save transforms.
+         * @return Real FFT size, 0 for the Direct method.
+         */
+        [[nodiscard]] int fftSize() const {
+            return blockFftSize;
+        }
+
+        /**
+         * Filter and decimate a signal.
+         *
+         * output[m] = sum_k kernel[k] * input[m * decimationFactor + delay - k], with input
+         * samples outside the signal taken as zero. A symmetric kernel of 2 * delay + 1 taps
+         * is thereby applied with zero phase.
+         *
+         * @param input Input samples.
+         * @param delay Number of samples by which the output is advanced against the input.
+         * @return input.size() / decimationFactor output samples.
+         */
+        [[nodiscard]] std::vector<float> apply(const std::vector<float> &input, int delay = 0) const;
+
+    private:
+        std::vector<float> kernel;
+        int factor;
+        /// Taps per polyphase branch, ceil(taps / factor).
+        int branchTaps;
+        FirMethod firMethod;
+        /// Non-zero taps kernel[j * factor + p] of branch p as j and value, at branchOffsets[p] .. branchOffsets[p + 1] - 1.
+        std::vector<int> tapDelays;
+        std::vector<float> tapValues;
+        std::vector<int> branchOffsets;
+
+        int blockFftSize = 0;
+        /// Per branch, the blockFftSize / 2 + 1 interleaved bins of the branch zero-padded to
+        /// blockFftSize and divided by blockFftSize.
+        std::vector<float> branchSpectra;
+
+        [[nodiscard]] std::vector<float> applyDirect(const std::vector<float> &input, int delay) const;
+
+        [[nodiscard]] std::vector<float> applyOverlapSave(const std::vector<float> &input, int delay) const;
+    };
+}
+
+#endif //PYTOTUNE_FIR_FILTER_H
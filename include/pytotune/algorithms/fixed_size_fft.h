@@ -0,0 +1,73 @@
+#ifndef PYTOTUNE_FIXED_SIZE_FFT_H
+#define PYTOTUNE_FIXED_SIZE_FFT_H
+
+namespace p2t {
+    /// Smallest transform size with a compile-time specialized FFT.
+    constexpr int MIN_FIXED_FFT_SIZE = 64;
+    /// Largest transform size with a compile-time specialized FFT.
+    constexpr int MAX_FIXED_FFT_SIZE = 8192;
+
+    /**
+     * Radix-2 FFT specialized for one power-of-two size at compile time.
+     *
+     * The bit-reversal permutation and twiddles are constexpr tables and every
+     * stage is its own instantiation, so all loop bounds and strides are
+     * constants the compiler can fold and unroll. Instantiated for every power
+     * of two from MIN_FIXED_FFT_SIZE to MAX_FIXED_FFT_SIZE.
+     *
+     * @tparam N Number of complex samples.
+     */
+    template<int N>
+    struct Fft {
+        static_assert(N >= MIN_FIXED_FFT_SIZE && N <= MAX_FIXED_FFT_SIZE && (N & (N - 1)) == 0,
+                      "No fixed-size FFT for this size");
+
+        /**
+         * Perform an in-place FFT or inverse FFT, see FftPlan::execute().
+         * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with 2 * N floats.
+         * @param sign -1 for FFT, 1 for inverse FFT
+         */
+        static void transform(float *fftBuffer, int sign);
+
+        /**
+         * Perform an in-place FFT of a zero-padded buffer or one of which only the low bins are used,
+         * see FftPlan::executePruned().
+         * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with 2 * N floats.
+         * @param sign -1 for FFT, 1 for inverse FFT
+         * @param nonZeroInputs Number of leading non-zero complex samples, a power of two up to N.
+         * @param usedOutputs Number of leading bins to compute, a power of two up to N.
+         */
+        static void transformPruned(float *fftBuffer, int sign, int nonZeroInputs, int usedOutputs);
+    };
+
+    /**
+     * Check whether a compile-time specialized FFT exists for a size.
+     * @param n Number of complex samples.
+     * @return True if Fft<n> is available.
+     */
+    constexpr bool hasFixedSizeFft(const int n) {
+        return n >= MIN_FIXED_FFT_SIZE && n <= MAX_FIXED_FFT_SIZE && (n & (n - 1)) == 0;
+    }
+
+    /**
+     * Run the compile-time specialized FFT matching a runtime size.
+     * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with 2 * n floats.
+     * @param n Number of complex samples.
+     * @param sign -1 for FFT, 1 for inverse FFT
+     * @return False, leaving the buffer untouched, if there is no specialization for n.
+     */
+    bool fixedSizeFft(float *fftBuffer, int n, int sign);
+
+    /**
+     * Run the compile-time specialized pruned FFT matching a runtime size, see Fft<N>::transformPruned().
+     * @param fftBuffer Interleaved buffer [Re0, Im0, Re1, Im1, ...] with 2 * n floats.
+     * @param n Number of complex samples.
+     * @param sign -1 for FFT, 1 for inverse FFT
+     * @param nonZeroInputs Number of leading non-zero complex samples, a power of two up to n.
+     * @param usedOutputs Number of leading bins to compute, a power of two up to n.
+     * @return False, leaving the buffer untouched, if there is no specialization for n.
+     */
+    bool fixedSizeFftPruned(float *fftBuffer, int n, int sign, int nonZeroInputs, int usedOutputs);
+}
+
+#endif //PYTOTUNE_FIXED_SIZE_FFT_H
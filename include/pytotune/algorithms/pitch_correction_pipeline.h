@@ -27,13 +27,17 @@ namespace p2t {
          * @param pitchRange Minimum and maximum detectable pitch in Hz.
          * @param threshold YIN confidence threshold.
          * @param decimationFactor Downsampling factor used during detection.
+         * @param method Computation of the YIN difference function.
+         * @param mode Search of the period.
          * @return Window-aligned detected pitch values in Hz.
          */
         WindowedData<float> detectPitch(const WavFile &src,
                                         Windowing windowing,
                                         PitchRange pitchRange,
                                         float threshold = DEFAULT_THRESHOLD,
-                                        int decimationFactor = DEFAULT_DECIMATION_FACTOR) const;
+                                        int decimationFactor = DEFAULT_DECIMATION_FACTOR,
+                                        DifferenceMethod method = DifferenceMethod::Auto,
+                                        SearchMode mode = SearchMode::Decimated) const;
 
         /**
          * Apply per-window correction factors and return pitch-shifted audio.
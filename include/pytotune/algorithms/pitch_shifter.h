@@ -21,8 +21,10 @@ namespace p2t {
          * Construct a pitch shifter with fixed processing parameters.
          * @param windowing Window size and hop size used during processing.
          * @param sampleRate Audio sample rate in Hz.
+         * @throws std::invalid_argument If the windowing is not supported, see Windowing::validateForFft().
          */
         explicit PitchShifter(Windowing windowing, float sampleRate) : windowing(windowing), sampleRate(sampleRate) {
+            windowing.validateForFft();
         }
 
         /**
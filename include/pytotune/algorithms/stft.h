@@ -0,0 +1,139 @@
+#ifndef PYTOTUNE_STFT_H
+#define PYTOTUNE_STFT_H
+
+#include <span>
+#include <vector>
+
+#include "pytotune/algorithms/fft.h"
+#include "pytotune/data-structures/windowing.h"
+
+namespace p2t {
+    /**
+     * Fused short-time Fourier analysis of a phase vocoder.
+     *
+     * Frame f covers the samples f * stride .. f * stride + windowSize - 1. Each
+     * frame is loaded with a precomputed Hann window, transformed with a real FFT
+     * and turned into magnitude and phase in place, so every frame is touched in
+     * one cache-resident pass. Only the phase differences between consecutive
+     * frames depend on frame order; they are taken afterwards by trueFrequency().
+     *
+     * An analyzer owns FFT scratch space, so each thread needs its own instance.
+     */
+    class StftAnalyzer {
+    public:
+        /**
+         * Construct an analyzer for one windowing configuration.
+         * @param windowing Window size and hop size of the frames.
+         * @param sampleRate Audio sample rate in Hz.
+         * @throws std::invalid_argument If the windowing is not supported, see Windowing::validateForFft().
+         */
+        StftAnalyzer(Windowing windowing, float sampleRate);
+
+        /**
+         * Get the number of bins per frame.
+         * @return windowSize / 2 + 1.
+         */
+        [[nodiscard]] int numBins() const {
+            return windowing.windowSize / 2 + 1;
+        }
+
+        /**
+         * Get the number of floats a frame buffer must hold.
+         * @return windowSize + 2, two floats per bin.
+         */
+        [[nodiscard]] int frameSize() const {
+            return windowing.windowSize + 2;
+        }
+
+        /**
+         * Window, transform and convert consecutive frames.
+         * @param samples Input mono audio samples; samples past the end count as zero.
+         * @param firstFrame Index of the first frame.
+         * @param count Number of frames.
+         * @param frames count buffers of frameSize() floats, receiving [magnitude, phase] per bin.
+         */
+        void analyze(const std::vector<float> &samples, int firstFrame, int count, float *const *frames) const;
+
+        /**
+         * Replace the phases of an analyzed frame by the true frequencies of its partials.
+         *
+         * Must be called for the frames in order, as each frame is measured
+         * against the phases of the previous one.
+         *
+         * @param frame Frame from analyze(), receiving [magnitude, frequency in Hz] per bin.
+         * @param lastPhase numBins() phases of the previous frame (zeros before the first), updated to this frame.
+         */
+        void trueFrequency(float *frame, float *lastPhase) const;
+
+    private:
+        Windowing windowing;
+        RealFftPlan fftPlan;
+        /// Hann analysis window, evaluated once in double precision.
+        std::vector<float> window;
+        /// Expected phase advance per bin index between frames, 2π * stride / windowSize.
+        float expect;
+        float freqPerBin;
+    };
+
+    /**
+     * Fused short-time Fourier synthesis of a phase vocoder, the counterpart of StftAnalyzer.
+     *
+     * Frames of [magnitude, phase] per bin are converted to complex bins and
+     * inverse transformed with a real FFT in place, then overlap-added with a
+     * precomputed synthesis window that already includes the FFT and overlap
+     * scaling. Overlap-add writes plain sums: frames whose indices differ by at
+     * least overlapFrames() never touch the same output sample, so callers can
+     * add such frames from several threads without atomics.
+     *
+     * A synthesizer owns FFT scratch space, so each thread needs its own instance.
+     */
+    class StftSynthesizer {
+    public:
+        /**
+         * Construct a synthesizer for one windowing configuration.
+         * @param windowing Window size and hop size of the frames.
+         * @throws std::invalid_argument If the windowing is not supported, see Windowing::validateForFft().
+         */
+        explicit StftSynthesizer(Windowing windowing);
+
+        /**
+         * Get the number of floats a frame buffer must hold.
+         * @return windowSize + 2, two floats per bin.
+         */
+        [[nodiscard]] int frameSize() const {
+            return windowing.windowSize + 2;
+        }
+
+        /**
+         * Get the distance in frames from which two frames no longer overlap.
+         * @return ceil(windowSize / stride).
+         */
+        [[nodiscard]] int overlapFrames() const {
+            return (windowing.windowSize + windowing.stride - 1) / windowing.stride;
+        }
+
+        /**
+         * Inverse transform frames in place.
+         * @param frames count buffers of frameSize() floats holding [magnitude, phase] for bins
+         *               0..windowSize/2, receiving windowSize time-domain samples.
+         * @param count Number of frames.
+         */
+        void synthesize(float *const *frames, int count) const;
+
+        /**
+         * Add a synthesized frame to the output with the scaled synthesis window applied.
+         * @param frame Frame from synthesize().
+         * @param frameIndex Index of the frame; it starts at output sample frameIndex * stride.
+         * @param output Output signal; samples past its end are dropped.
+         */
+        void overlapAdd(const float *frame, int frameIndex, std::span<float> output) const;
+
+    private:
+        Windowing windowing;
+        RealFftPlan fftPlan;
+        /// Hann synthesis window divided by windowSize / 2 * osamp, evaluated once in double precision.
+        std::vector<float> scaledWindow;
+    };
+}
+
+#endif //PYTOTUNE_STFT_H
@@ -34,6 +34,16 @@ namespace p2t {
         int getOsamp() const {
             return windowSize / stride;
         }
+
+        /**
+         * Check that windows of this configuration can be transformed by the real FFT of the phase vocoder.
+         * Any even window size is supported, not only powers of two.
+         * @throws std::invalid_argument If the window size is not positive and even, or the stride is not
+         *                               between 1 and the window size or does not divide it, as the hop and
+         *                               bin arithmetic and the overlap-add normalization of the phase vocoder
+         *                               assume windowSize / stride hops per window.
+         */
+        void validateForFft() const;
     };
 
     /**
@@ -12,107 +12,1178 @@
 ****************************************************************************/
 
 #include "pytotune/algorithms/fft.h"
+#include "pytotune/algorithms/fft_planner.h"
+#include "pytotune/algorithms/fixed_size_fft.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <omp.h>
+
+#include "hwy/highway.h"
+
+using namespace hwy::HWY_NAMESPACE;
 
 namespace p2t {
-    void smbFft(std::vector<float> &fftBuffer, const int fftFrameSize, const int sign) {
-        if (fftFrameSize <= 0) return;
-        const int n = fftFrameSize;
-        if (fftBuffer.size() < 2 * n) return;
+    namespace {
+        int realHalfSize(const int fftFrameSize) {
+            if (fftFrameSize < 2 || fftFrameSize % 2 != 0) {
+                throw std::invalid_argument(
+                    "Real FFT size must be even and at least 2 but got: " + std::to_string(fftFrameSize));
+            }
+            return fftFrameSize / 2;
+        }
 
-        // Check N is power of two, compute numStages
-        int t = n;
-        int numStages = 0;
-        while (t > 1) {
-            if (t % 2 != 0) return; // not power of two
-            t >>= 1;
-            ++numStages;
+        /// Transpose a rows x columns matrix of interleaved complex values in tiles that stay in L1.
+        void transposeComplex(const float *source, float *destination, const int rows, const int columns,
+                              const bool parallel) {
+            constexpr int tile = 16;
+#pragma omp parallel for schedule(static) if (parallel)
+            for (int r0 = 0; r0 < rows; r0 += tile) {
+                const int r1 = std::min(r0 + tile, rows);
+                for (int c0 = 0; c0 < columns; c0 += tile) {
+                    const int c1 = std::min(c0 + tile, columns);
+                    for (int r = r0; r < r1; ++r) {
+                        for (int c = c0; c < c1; ++c) {
+                            const size_t from = 2 * (static_cast<size_t>(r) * columns + c);
+                            const size_t to = 2 * (static_cast<size_t>(c) * rows + r);
+                            destination[to] = source[from];
+                            destination[to + 1] = source[from + 1];
+                        }
+                    }
+                }
+            }
         }
 
-        // Bit reversal on complex indices 0..N-1
-        auto bitReverse = [&](int x, const int bits)-> int {
-            int y = 0;
-            for (int i = 0; i < bits; ++i) {
-                y = (y << 1) | (x & 1);
-                x >>= 1;
+        /**
+         * Gather an interleaved buffer in bit-reversed order into split real and imaginary parts,
+         * running the first two radix-2 stages on the way. They only use the twiddles 1 and ±i.
+         */
+        void gatherRadix4(const float *fftBuffer, const int *bitReversal, const int n, const float fsign, float *re,
+                          float *im) {
+            for (int i = 0; i < n; i += 4) {
+                const float *a = fftBuffer + 2 * bitReversal[i];
+                const float *b = fftBuffer + 2 * bitReversal[i + 1];
+                const float *c = fftBuffer + 2 * bitReversal[i + 2];
+                const float *e = fftBuffer + 2 * bitReversal[i + 3];
+
+                const float s0r = a[0] + b[0], s0i = a[1] + b[1];
+                const float d0r = a[0] - b[0], d0i = a[1] - b[1];
+                const float s1r = c[0] + e[0], s1i = c[1] + e[1];
+                // (c - e) * (sign * i)
+                const float d1r = -fsign * (c[1] - e[1]), d1i = fsign * (c[0] - e[0]);
+
+                re[i] = s0r + s1r;
+                im[i] = s0i + s1i;
+                re[i + 1] = d0r + d1r;
+                im[i + 1] = d0i + d1i;
+                re[i + 2] = s0r - s1r;
+                im[i + 2] = s0i - s1i;
+                re[i + 3] = d0r - d1r;
+                im[i + 3] = d0i - d1i;
             }
-            return y;
-        };
+        }
+    }
+
+    const char *fftKernelName(const FftKernel kernel) {
+        switch (kernel) {
+            case FftKernel::Radix2:
+                return "radix2";
+            case FftKernel::Simd:
+                return "simd";
+            case FftKernel::Radix4:
+                return "radix4";
+            case FftKernel::Stockham:
+                return "stockham";
+            case FftKernel::MixedRadix:
+                return "mixedradix";
+            case FftKernel::Bluestein:
+                return "bluestein";
+            case FftKernel::FixedSize:
+                return "fixedsize";
+            case FftKernel::FourStep:
+                return "fourstep";
+            case FftKernel::Auto:
+                return "auto";
+        }
+        return "unknown";
+    }
+
+    FftPlan::FftPlan(const int fftFrameSize, const FftKernel kernel, const bool parallel)
+        : n(fftFrameSize), numStages(0), fftKernel(kernel), parallel(parallel) {
+        if (n <= 0) {
+            throw std::invalid_argument("FFT size must be positive but got: " + std::to_string(n));
+        }
+
+        if (fftKernel == FftKernel::Auto) {
+            fftKernel = plannedFftKernel(n);
+        }
+
+        const bool powerOfTwo = (n & (n - 1)) == 0;
+        if (!powerOfTwo && fftKernel != FftKernel::MixedRadix && fftKernel != FftKernel::Bluestein) {
+            fftKernel = FftKernel::MixedRadix;
+        }
+
+        if (fftKernel == FftKernel::FixedSize && !hasFixedSizeFft(n)) {
+            fftKernel = DEFAULT_FFT_KERNEL;
+        }
+
+        if (!powerOfTwo) {
+            this->parallel = false;
+        } else if (parallel && fftKernel != FftKernel::Radix2 && fftKernel != FftKernel::FourStep) {
+            fftKernel = FftKernel::FourStep;
+        }
+
+        if (fftKernel == FftKernel::MixedRadix) {
+            // Radix 4 first as it needs the fewest operations per point, then the remaining small primes
+            int remaining = n;
+            for (const int radix: {4, 2, 3, 5, 7}) {
+                while (remaining % radix == 0) {
+                    radices.push_back(radix);
+                    remaining /= radix;
+                }
+            }
+            if (remaining != 1) {
+                radices.clear();
+                fftKernel = FftKernel::Bluestein;
+            }
+        }
+
+        if (powerOfTwo) {
+            while ((1 << numStages) < n) ++numStages;
+        }
+
+        // FourStep only needs the tables of its much smaller sub-plans
+        if (powerOfTwo && fftKernel != FftKernel::FourStep) {
+            // Bit reversal on complex indices 0..N-1
+            bitReversal.resize(n);
+            bitReversal[0] = 0;
+            for (int i = 1; i < n; ++i) {
+                bitReversal[i] = (bitReversal[i >> 1] >> 1) | ((i & 1) << (numStages - 1));
+            }
+
+            // Exact twiddles for every stage, evaluated in double precision so no error accumulates
+            twiddleCos.resize(std::max(n - 1, 1));
+            twiddleSin.resize(std::max(n - 1, 1));
+            for (int le = 2; le <= n; le <<= 1) {
+                const int le2 = le >> 1;
+                for (int k = 0; k < le2; ++k) {
+                    const double angle = 2.0 * M_PI * static_cast<double>(k) / static_cast<double>(le);
+                    twiddleCos[le2 - 1 + k] = static_cast<float>(std::cos(angle));
+                    twiddleSin[le2 - 1 + k] = static_cast<float>(std::sin(angle));
+                }
+            }
+        }
+
+        if (fftKernel == FftKernel::Simd || fftKernel == FftKernel::Stockham || fftKernel == FftKernel::MixedRadix ||
+            fftKernel == FftKernel::FourStep) {
+            scratch.resize(2 * n);
+        }
+
+        if (fftKernel == FftKernel::Radix4) {
+            // W^3k is the only radix-4 twiddle not already in the radix-2 tables (W^k of stage 4L, W^2k of stage 2L)
+            twiddle3Cos.resize(std::max(n, 1));
+            twiddle3Sin.resize(std::max(n, 1));
+            for (int quarter = (numStages % 2 == 1) ? 2 : 1; 4 * quarter <= n; quarter <<= 2) {
+                for (int k = 0; k < quarter; ++k) {
+                    const double angle = 2.0 * M_PI * 3.0 * static_cast<double>(k) / static_cast<double>(4 * quarter);
+                    twiddle3Cos[quarter - 1 + k] = static_cast<float>(std::cos(angle));
+                    twiddle3Sin[quarter - 1 + k] = static_cast<float>(std::sin(angle));
+                }
+            }
+        }
+
+        if (fftKernel == FftKernel::MixedRadix) {
+            for (int len = n, r = 0; r < static_cast<int>(radices.size()); len /= radices[r], ++r) {
+                const int radix = radices[r];
+                for (int j = 0; j < len / radix; ++j) {
+                    for (int u = 1; u < radix; ++u) {
+                        const double angle = 2.0 * M_PI * static_cast<double>(j) * u / static_cast<double>(len);
+                        mixedCos.push_back(static_cast<float>(std::cos(angle)));
+                        mixedSin.push_back(static_cast<float>(std::sin(angle)));
+                    }
+                }
+            }
+        }
+
+        if (fftKernel == FftKernel::FourStep) {
+            // Never fewer rows than columns, so the strided column pass reads whole cache lines per row
+            fourStepColumns = 1 << (numStages / 2);
+            fourStepRows = n / fourStepColumns;
+            columnPlans.push_back(std::make_unique<FftPlan>(fourStepRows, FftKernel::FixedSize));
+            rowPlans.push_back(std::make_unique<FftPlan>(fourStepColumns, FftKernel::FixedSize));
+
+            fourStepCos.resize(n);
+            fourStepSin.resize(n);
+            for (int c = 0; c < fourStepColumns; ++c) {
+                for (int r = 0; r < fourStepRows; ++r) {
+                    // r * c < N, so the angle stays exact in double precision
+                    const double angle = 2.0 * M_PI * static_cast<double>(r) * c / static_cast<double>(n);
+                    fourStepCos[static_cast<size_t>(c) * fourStepRows + r] = static_cast<float>(std::cos(angle));
+                    fourStepSin[static_cast<size_t>(c) * fourStepRows + r] = static_cast<float>(std::sin(angle));
+                }
+            }
+        }
+
+        if (fftKernel == FftKernel::Bluestein) {
+            int innerSize = 1;
+            while (innerSize < 2 * n - 1) innerSize <<= 1;
+            innerPlan = std::make_unique<FftPlan>(innerSize);
+
+            // exp(-iπk²/N), with k² reduced mod 2N first so large k keep full precision
+            chirp.resize(2 * n);
+            for (int k = 0; k < n; ++k) {
+                const long long k2 = static_cast<long long>(k) * k % (2LL * n);
+                const double angle = M_PI * static_cast<double>(k2) / static_cast<double>(n);
+                chirp[2 * k] = static_cast<float>(std::cos(angle));
+                chirp[2 * k + 1] = static_cast<float>(-std::sin(angle));
+            }
+
+            // Conjugate chirp for lags -(N-1)..N-1, wrapped around, transformed and pre-scaled by 1/innerSize
+            chirpSpectrum.assign(2 * innerSize, 0.0f);
+            for (int k = 0; k < n; ++k) {
+                const float scale = 1.0f / static_cast<float>(innerSize);
+                chirpSpectrum[2 * k] = chirp[2 * k] * scale;
+                chirpSpectrum[2 * k + 1] = -chirp[2 * k + 1] * scale;
+                if (k > 0) {
+                    chirpSpectrum[2 * (innerSize - k)] = chirpSpectrum[2 * k];
+                    chirpSpectrum[2 * (innerSize - k) + 1] = chirpSpectrum[2 * k + 1];
+                }
+            }
+            innerPlan->execute(chirpSpectrum.data(), -1);
+            scratch.resize(2 * innerSize);
+        }
+    }
+
+    void FftPlan::execute(float *fftBuffer, const int sign) const {
+        switch (fftKernel) {
+            case FftKernel::Simd:
+                executeSimd(fftBuffer, sign);
+                return;
+            case FftKernel::Radix4:
+                executeRadix4(fftBuffer, sign);
+                return;
+            case FftKernel::Stockham:
+                executeStockham(fftBuffer, sign);
+                return;
+            case FftKernel::MixedRadix:
+                executeMixedRadix(fftBuffer, sign);
+                return;
+            case FftKernel::Bluestein:
+                executeBluestein(fftBuffer, sign);
+                return;
+            case FftKernel::FixedSize:
+                fixedSizeFft(fftBuffer, n, sign);
+                return;
+            case FftKernel::FourStep:
+                executeFourStep(fftBuffer, sign);
+                return;
+            case FftKernel::Radix2:
+            default:
+                if (parallel) {
+                    executeRadix2Parallel(fftBuffer, sign);
+                } else {
+                    executeRadix2(fftBuffer, sign);
+                }
+        }
+    }
+
+    void FftPlan::executeBatch(float *const *frames, const int count, const int sign) const {
+        int done = 0;
+
+# if USE_HWY
+        const ScalableTag<float> d;
+        const int lanes = static_cast<int>(Lanes(d));
+        // The transposed path runs radix-2 stages, so it needs a power-of-two size
+        if (lanes > 1 && count >= lanes && !bitReversal.empty()) {
+            const size_t laneStride = static_cast<size_t>(lanes);
+            batchScratch.resize(2 * static_cast<size_t>(n) * laneStride);
+            float *re = batchScratch.data();
+            float *im = re + static_cast<size_t>(n) * laneStride;
+            const auto vsign = Set(d, static_cast<float>(sign));
 
-        int const bits = numStages;
+            for (; done + lanes <= count; done += lanes) {
+                float *const *group = frames + done;
+
+                // Transpose in bit-reversed order: element i of frame f goes to lane f of vector i
+                for (int i = 0; i < n; ++i) {
+                    const int j = 2 * bitReversal[i];
+                    for (int f = 0; f < lanes; ++f) {
+                        re[i * laneStride + f] = group[f][j];
+                        im[i * laneStride + f] = group[f][j + 1];
+                    }
+                }
+
+                // Same radix-2 stages as executeRadix2, each scalar now being a vector of frames
+                for (int le = 2; le <= n; le <<= 1) {
+                    const int le2 = le >> 1;
+                    const float *stageCos = twiddleCos.data() + le2 - 1;
+                    const float *stageSin = twiddleSin.data() + le2 - 1;
+                    for (int k = 0; k < le2; ++k) {
+                        const auto wr = Set(d, stageCos[k]);
+                        const auto wi = Set(d, stageSin[k]) * vsign;
+                        for (int blockStart = 0; blockStart < n; blockStart += le) {
+                            const size_t p1 = static_cast<size_t>(blockStart + k) * laneStride;
+                            const size_t p2 = p1 + static_cast<size_t>(le2) * laneStride;
+
+                            const auto r1 = LoadU(d, re + p1);
+                            const auto i1 = LoadU(d, im + p1);
+                            const auto r2 = LoadU(d, re + p2);
+                            const auto i2 = LoadU(d, im + p2);
+
+                            // t = W * lower
+                            const auto tr = MulSub(r2, wr, i2 * wi);
+                            const auto ti = MulAdd(r2, wi, i2 * wr);
+
+                            StoreU(r1 - tr, d, re + p2);
+                            StoreU(i1 - ti, d, im + p2);
+                            StoreU(r1 + tr, d, re + p1);
+                            StoreU(i1 + ti, d, im + p1);
+                        }
+                    }
+                }
+
+                for (int i = 0; i < n; ++i) {
+                    for (int f = 0; f < lanes; ++f) {
+                        group[f][2 * i] = re[i * laneStride + f];
+                        group[f][2 * i + 1] = im[i * laneStride + f];
+                    }
+                }
+            }
+        }
+# endif
+
+        // Remaining frames one at a time
+        for (; done < count; ++done) {
+            execute(frames[done], sign);
+        }
+    }
+
+    void FftPlan::executePruned(float *fftBuffer, const int sign, const int nonZeroInputs,
+                                const int usedOutputs) const {
+        if (nonZeroInputs <= 0 || usedOutputs <= 0) {
+            throw std::invalid_argument("Pruned FFT needs positive input and output counts but got: " +
+                                        std::to_string(nonZeroInputs) + ", " + std::to_string(usedOutputs));
+        }
+
+        int inputs = 1;
+        while (inputs < std::min(nonZeroInputs, n)) inputs <<= 1;
+        int outputs = 1;
+        while (outputs < std::min(usedOutputs, n)) outputs <<= 1;
+        if (inputs == n && outputs == n) {
+            execute(fftBuffer, sign);
+            return;
+        }
+        // The fixed-size stages also serve FourStep plans, which have no radix-2 tables of their own
+        if ((fftKernel == FftKernel::FixedSize || fftKernel == FftKernel::FourStep) &&
+            fixedSizeFftPruned(fftBuffer, n, sign, inputs, outputs)) {
+            return;
+        }
+        if (bitReversal.empty() || n < 4) {
+            execute(fftBuffer, sign);
+            return;
+        }
+
+        prunedScratch.resize(2 * static_cast<size_t>(n));
+        float *re = prunedScratch.data();
+        float *im = re + n;
+        const auto fsign = static_cast<float>(sign);
+
+        // Bit reversal moves input j < L to (N/L) * rev_L(j), followed by N/L - 1 zeros. The first
+        // log2(N/L) stages turn each such block into the DFT of an impulse: the input repeated.
+        const int replicas = n / inputs;
+        int firstStage = 8;
+        if (replicas == 1) {
+            gatherRadix4(fftBuffer, bitReversal.data(), n, fsign, re, im);
+        } else if (replicas == 2) {
+            // Stage 4 on the blocks [a, a, b, b], with the twiddles 1 and ±i
+            for (int i = 0; i < n; i += 4) {
+                const float *a = fftBuffer + 2 * bitReversal[i];
+                const float *b = fftBuffer + 2 * bitReversal[i + 2];
+                // b * (sign * i)
+                const float tr = -fsign * b[1], ti = fsign * b[0];
+
+                re[i] = a[0] + b[0];
+                im[i] = a[1] + b[1];
+                re[i + 1] = a[0] + tr;
+                im[i + 1] = a[1] + ti;
+                re[i + 2] = a[0] - b[0];
+                im[i + 2] = a[1] - b[1];
+                re[i + 3] = a[0] - tr;
+                im[i + 3] = a[1] - ti;
+            }
+        } else {
+            for (int m = 0; m < inputs; ++m) {
+                const int j = bitReversal[m * replicas];
+                std::fill_n(re + m * replicas, replicas, fftBuffer[2 * j]);
+                std::fill_n(im + m * replicas, replicas, fftBuffer[2 * j + 1]);
+            }
+            firstStage = 2 * replicas;
+        }
+
+# if USE_HWY
+        const ScalableTag<float> d;
+        const int lanes = static_cast<int>(Lanes(d));
+        const auto vsign = Set(d, fsign);
+# endif
+
+        for (int le = firstStage; le <= n; le <<= 1) {
+            const int le2 = le >> 1;
+            const float *stageCos = twiddleCos.data() + le2 - 1;
+            const float *stageSin = twiddleSin.data() + le2 - 1;
+            // Only bins below K of every block are read later: past that, the lower outputs are never needed
+            const bool lowerUsed = outputs > le2;
+            const int butterflies = lowerUsed ? le2 : outputs;
+
+            for (int blockStart = 0; blockStart < n; blockStart += le) {
+                float *re1 = re + blockStart;
+                float *im1 = im + blockStart;
+                float *re2 = re1 + le2;
+                float *im2 = im1 + le2;
+                int k = 0;
+# if USE_HWY
+                for (; k + lanes <= butterflies; k += lanes) {
+                    const auto wr = LoadU(d, stageCos + k);
+                    const auto wi = LoadU(d, stageSin + k) * vsign;
+                    const auto r1 = LoadU(d, re1 + k);
+                    const auto i1 = LoadU(d, im1 + k);
+                    const auto r2 = LoadU(d, re2 + k);
+                    const auto i2 = LoadU(d, im2 + k);
+                    const auto tr = MulSub(r2, wr, i2 * wi);
+                    const auto ti = MulAdd(r2, wi, i2 * wr);
+
+                    if (lowerUsed) {
+                        StoreU(r1 - tr, d, re2 + k);
+                        StoreU(i1 - ti, d, im2 + k);
+                    }
+                    StoreU(r1 + tr, d, re1 + k);
+                    StoreU(i1 + ti, d, im1 + k);
+                }
+# endif
+                for (; k < butterflies; ++k) {
+                    const float wr = stageCos[k];
+                    const float wi = fsign * stageSin[k];
+                    const float tr = re2[k] * wr - im2[k] * wi;
+                    const float ti = re2[k] * wi + im2[k] * wr;
+
+                    if (lowerUsed) {
+                        re2[k] = re1[k] - tr;
+                        im2[k] = im1[k] - ti;
+                    }
+                    re1[k] += tr;
+                    im1[k] += ti;
+                }
+            }
+        }
+
+        for (int i = 0; i < outputs; ++i) {
+            fftBuffer[2 * i] = re[i];
+            fftBuffer[2 * i + 1] = im[i];
+        }
+    }
+
+    void FftPlan::bitReverse(float *fftBuffer) const {
         for (int i = 0; i < n; ++i) {
-            int j = bitReverse(i, bits);
+            const int j = bitReversal[i];
             if (j > i) {
                 std::swap(fftBuffer[2 * i], fftBuffer[2 * j]);
                 std::swap(fftBuffer[2 * i + 1], fftBuffer[2 * j + 1]);
             }
         }
+    }
+
+    void FftPlan::executeRadix2(float *fftBuffer, const int sign) const {
+        bitReverse(fftBuffer);
+
+        const auto fsign = static_cast<float>(sign);
 
         // Danielson-Lanczos / iterative radix-2
         // le = current DFT length in complex samples: 2,4,8,...,N
         for (int le = 2; le <= n; le <<= 1) {
-            int le2 = le >> 1; // half size (butterfly distance)
-            // compute basic angular increment for this stage
-            // angle increment for k = 1: theta = sign * 2π / le
-            float theta = static_cast<float>(sign) * 2.f * static_cast<float>(M_PI) / static_cast<float>(le);
+            const int le2 = le >> 1; // half size (butterfly distance)
 #if USE_PREDEFINED_TWIDDLES
-            // Precompute W1 = exp(i * theta)
-            float wpr = std::cos(theta);
-            float wpi = std::sin(theta);
-
-            // Start with W0 = 1 + 0i
-            float wr = 1.0f;
-            float wi = 0.0f;
+            const float *stageCos = twiddleCos.data() + le2 - 1;
+            const float *stageSin = twiddleSin.data() + le2 - 1;
+#else
+            // angle increment for k = 1: theta = 2π / le
+            const float theta = 2.f * static_cast<float>(M_PI) / static_cast<float>(le);
 #endif
 
-
-            // We will compute twiddles via recurrence to avoid many cos/sin calls.
-            // For each k from 0..le2-1 compute W = exp(j * k * theta)
             for (int k = 0; k < le2; ++k) {
-                // twiddle W = cos(k*theta) + j*sin(k*theta)
-#if not USE_PREDEFINED_TWIDDLES
+                // twiddle W = cos(k*theta) + j*sign*sin(k*theta)
+#if USE_PREDEFINED_TWIDDLES
+                const float wr = stageCos[k];
+                const float wi = fsign * stageSin[k];
+#else
                 const float wr = std::cos(static_cast<float>(k) * theta);
-                const float wi = std::sin(static_cast<float>(k) * theta);
+                const float wi = fsign * std::sin(static_cast<float>(k) * theta);
 #endif
                 // Perform butterflies for this twiddle across all blocks
                 for (int blockStart = 0; blockStart < n; blockStart += le) {
-                    int i1 = blockStart + k; // index of upper complex sample
-                    int i2 = i1 + le2; // index of lower complex sample
+                    const int p1 = 2 * (blockStart + k); // upper complex sample
+                    const int p2 = p1 + 2 * le2; // lower complex sample
 
-                    int p1 = 2 * i1;
-                    int p1i = p1 + 1;
-                    int p2 = 2 * i2;
-                    int p2i = p2 + 1;
-
-                    float r1 = fftBuffer[p1];
-                    float i1v = fftBuffer[p1i];
-                    float r2 = fftBuffer[p2];
-                    float i2v = fftBuffer[p2i];
+                    const float r1 = fftBuffer[p1];
+                    const float i1 = fftBuffer[p1 + 1];
+                    const float r2 = fftBuffer[p2];
+                    const float i2 = fftBuffer[p2 + 1];
 
                     // t = W * lower
-                    float tr = r2 * wr - i2v * wi;
-                    float ti = r2 * wi + i2v * wr;
+                    const float tr = r2 * wr - i2 * wi;
+                    const float ti = r2 * wi + i2 * wr;
 
                     // lower = upper - t
                     fftBuffer[p2] = r1 - tr;
-                    fftBuffer[p2i] = i1v - ti;
+                    fftBuffer[p2 + 1] = i1 - ti;
 
                     // upper = upper + t
                     fftBuffer[p1] = r1 + tr;
-                    fftBuffer[p1i] = i1v + ti;
+                    fftBuffer[p1 + 1] = i1 + ti;
                 }
+            }
+        }
+    }
 
-#if USE_PREDEFINED_TWIDDLES
-                // Wk+1 = Wk * W1
-                float nextWr = wr * wpr - wi * wpi;
-                float nextWi = wr * wpi + wi * wpr;
+    void FftPlan::executeRadix2Parallel(float *fftBuffer, const int sign) const {
+        const auto fsign = static_cast<float>(sign);
 
-                wr = nextWr;
-                wi = nextWi;
-#endif
+#pragma omp parallel
+        {
+            // Every index pair is swapped by exactly one iteration
+#pragma omp for schedule(static)
+            for (int i = 0; i < n; ++i) {
+                const int j = bitReversal[i];
+                if (j > i) {
+                    std::swap(fftBuffer[2 * i], fftBuffer[2 * j]);
+                    std::swap(fftBuffer[2 * i + 1], fftBuffer[2 * j + 1]);
+                }
+            }
+
+            for (int le = 2; le <= n; le <<= 1) {
+                const int le2 = le >> 1;
+                const float *stageCos = twiddleCos.data() + le2 - 1;
+                const float *stageSin = twiddleSin.data() + le2 - 1;
+
+                // Early stages have many independent blocks, late stages many twiddles per block.
+                // The implicit barrier of each omp for keeps the stages in order.
+                if (n / le >= le2) {
+#pragma omp for schedule(static)
+                    for (int blockStart = 0; blockStart < n; blockStart += le) {
+                        for (int k = 0; k < le2; ++k) {
+                            const float wr = stageCos[k];
+                            const float wi = fsign * stageSin[k];
+                            const int p1 = 2 * (blockStart + k);
+                            const int p2 = p1 + 2 * le2;
+
+                            const float tr = fftBuffer[p2] * wr - fftBuffer[p2 + 1] * wi;
+                            const float ti = fftBuffer[p2] * wi + fftBuffer[p2 + 1] * wr;
+                            fftBuffer[p2] = fftBuffer[p1] - tr;
+                            fftBuffer[p2 + 1] = fftBuffer[p1 + 1] - ti;
+                            fftBuffer[p1] += tr;
+                            fftBuffer[p1 + 1] += ti;
+                        }
+                    }
+                } else {
+#pragma omp for schedule(static)
+                    for (int k = 0; k < le2; ++k) {
+                        const float wr = stageCos[k];
+                        const float wi = fsign * stageSin[k];
+                        for (int blockStart = 0; blockStart < n; blockStart += le) {
+                            const int p1 = 2 * (blockStart + k);
+                            const int p2 = p1 + 2 * le2;
+
+                            const float tr = fftBuffer[p2] * wr - fftBuffer[p2 + 1] * wi;
+                            const float ti = fftBuffer[p2] * wi + fftBuffer[p2 + 1] * wr;
+                            fftBuffer[p2] = fftBuffer[p1] - tr;
+                            fftBuffer[p2 + 1] = fftBuffer[p1 + 1] - ti;
+                            fftBuffer[p1] += tr;
+                            fftBuffer[p1 + 1] += ti;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void FftPlan::executeSimd(float *fftBuffer, const int sign) const {
+        // Split layout: all real parts followed by all imaginary parts, gathered in bit-reversed order
+        float *re = scratch.data();
+        float *im = re + n;
+        const auto fsign = static_cast<float>(sign);
+        int le = 2;
+
+        if (n >= 4) {
+            // The first two stages only use the twiddles 1 and ±i, fuse them into the gather as a radix-4 pass
+            gatherRadix4(fftBuffer, bitReversal.data(), n, fsign, re, im);
+            le = 8;
+        } else {
+            for (int i = 0; i < n; ++i) {
+                const int j = bitReversal[i];
+                re[i] = fftBuffer[2 * j];
+                im[i] = fftBuffer[2 * j + 1];
+            }
+        }
+
+# if USE_HWY
+        const ScalableTag<float> d;
+        const int lanes = static_cast<int>(Lanes(d));
+# else
+        constexpr int lanes = 1 << 30; // everything takes the scalar path
+# endif
+
+        // Small stages have fewer butterflies per block than lanes, run them scalar
+        for (; le <= n && (le >> 1) < lanes; le <<= 1) {
+            const int le2 = le >> 1;
+            const float *stageCos = twiddleCos.data() + le2 - 1;
+            const float *stageSin = twiddleSin.data() + le2 - 1;
+            for (int blockStart = 0; blockStart < n; blockStart += le) {
+                for (int k = 0; k < le2; ++k) {
+                    const float wr = stageCos[k];
+                    const float wi = fsign * stageSin[k];
+                    const int i1 = blockStart + k;
+                    const int i2 = i1 + le2;
+                    const float tr = re[i2] * wr - im[i2] * wi;
+                    const float ti = re[i2] * wi + im[i2] * wr;
+                    re[i2] = re[i1] - tr;
+                    im[i2] = im[i1] - ti;
+                    re[i1] += tr;
+                    im[i1] += ti;
+                }
             }
         }
+
+# if USE_HWY
+        // Remaining stages: vectorize across the butterflies of each block, le2 is a multiple of lanes
+        const auto vsign = Set(d, fsign);
+        for (; le <= n; le <<= 1) {
+            const int le2 = le >> 1;
+            const float *stageCos = twiddleCos.data() + le2 - 1;
+            const float *stageSin = twiddleSin.data() + le2 - 1;
+            for (int blockStart = 0; blockStart < n; blockStart += le) {
+                float *re1 = re + blockStart;
+                float *im1 = im + blockStart;
+                float *re2 = re1 + le2;
+                float *im2 = im1 + le2;
+                for (int k = 0; k < le2; k += lanes) {
+                    const auto wr = LoadU(d, stageCos + k);
+                    const auto wi = LoadU(d, stageSin + k) * vsign;
+                    const auto r1 = LoadU(d, re1 + k);
+                    const auto i1 = LoadU(d, im1 + k);
+                    const auto r2 = LoadU(d, re2 + k);
+                    const auto i2 = LoadU(d, im2 + k);
+
+                    // t = W * lower
+                    const auto tr = MulSub(r2, wr, i2 * wi);
+                    const auto ti = MulAdd(r2, wi, i2 * wr);
+
+                    StoreU(r1 - tr, d, re2 + k);
+                    StoreU(i1 - ti, d, im2 + k);
+                    StoreU(r1 + tr, d, re1 + k);
+                    StoreU(i1 + ti, d, im1 + k);
+                }
+            }
+        }
+# endif
+
+        for (int i = 0; i < n; ++i) {
+            fftBuffer[2 * i] = re[i];
+            fftBuffer[2 * i + 1] = im[i];
+        }
+    }
+
+    void FftPlan::executeRadix4(float *fftBuffer, const int sign) const {
+        bitReverse(fftBuffer);
+
+        const auto fsign = static_cast<float>(sign);
+        int quarter = 1;
+
+        // Odd number of stages: one radix-2 stage with twiddle 1 first
+        if (numStages % 2 == 1) {
+            for (int i = 0; i < n; i += 2) {
+                const float r1 = fftBuffer[2 * i];
+                const float i1 = fftBuffer[2 * i + 1];
+                const float r2 = fftBuffer[2 * i + 2];
+                const float i2 = fftBuffer[2 * i + 3];
+                fftBuffer[2 * i] = r1 + r2;
+                fftBuffer[2 * i + 1] = i1 + i2;
+                fftBuffer[2 * i + 2] = r1 - r2;
+                fftBuffer[2 * i + 3] = i1 - i2;
+            }
+            quarter = 2;
+        }
+
+        // Radix-4 stages combine four length-L sub-DFTs into one of length 4L = le.
+        // In bit-reversed order the block holds the sub-DFTs of the samples = 0, 2, 1, 3 (mod 4) in that order.
+        for (; 4 * quarter <= n; quarter <<= 2) {
+            const int le = 4 * quarter;
+            const float *cos1 = twiddleCos.data() + 2 * quarter - 1; // W^k of stage le
+            const float *sin1 = twiddleSin.data() + 2 * quarter - 1;
+            const float *cos2 = twiddleCos.data() + quarter - 1; // W^2k == twiddle k of stage le/2
+            const float *sin2 = twiddleSin.data() + quarter - 1;
+            const float *cos3 = twiddle3Cos.data() + quarter - 1;
+            const float *sin3 = twiddle3Sin.data() + quarter - 1;
+
+            for (int k = 0; k < quarter; ++k) {
+                const float w1r = cos1[k], w1i = fsign * sin1[k];
+                const float w2r = cos2[k], w2i = fsign * sin2[k];
+                const float w3r = cos3[k], w3i = fsign * sin3[k];
+
+                for (int blockStart = 0; blockStart < n; blockStart += le) {
+                    float *x0 = fftBuffer + 2 * (blockStart + k);
+                    float *x1 = x0 + 2 * quarter;
+                    float *x2 = x1 + 2 * quarter;
+                    float *x3 = x2 + 2 * quarter;
+
+                    // a = S0, b = S1 W^k, c = S2 W^2k, d = S3 W^3k
+                    const float ar = x0[0], ai = x0[1];
+                    const float br = x2[0] * w1r - x2[1] * w1i, bi = x2[0] * w1i + x2[1] * w1r;
+                    const float cr = x1[0] * w2r - x1[1] * w2i, ci = x1[0] * w2i + x1[1] * w2r;
+                    const float dr = x3[0] * w3r - x3[1] * w3i, di = x3[0] * w3i + x3[1] * w3r;
+
+                    const float acr = ar + cr, aci = ai + ci;
+                    const float amcr = ar - cr, amci = ai - ci;
+                    const float bdr = br + dr, bdi = bi + di;
+                    // (b - d) * (sign * i)
+                    const float jbdr = -fsign * (bi - di), jbdi = fsign * (br - dr);
+
+                    x0[0] = acr + bdr;
+                    x0[1] = aci + bdi;
+                    x1[0] = amcr + jbdr;
+                    x1[1] = amci + jbdi;
+                    x2[0] = acr - bdr;
+                    x2[1] = aci - bdi;
+                    x3[0] = amcr - jbdr;
+                    x3[1] = amci - jbdi;
+                }
+            }
+        }
+    }
+
+    void FftPlan::executeStockham(float *fftBuffer, const int sign) const {
+        const auto fsign = static_cast<float>(sign);
+        float *x = fftBuffer;
+        float *y = scratch.data();
+
+        // Decimation in frequency: each stage splits every length-len sub-transform (elements strided by
+        // stride) into two of length len/2 and writes them interleaved, so the output ends up in natural
+        // order without a bit-reversal pass. Reads and writes along q are contiguous in every stage.
+        for (int len = n, stride = 1; len >= 2; len >>= 1, stride <<= 1) {
+            const int half = len >> 1;
+            const float *stageCos = twiddleCos.data() + half - 1;
+            const float *stageSin = twiddleSin.data() + half - 1;
+
+            for (int p = 0; p < half; ++p) {
+                const float wr = stageCos[p];
+                const float wi = fsign * stageSin[p];
+                const float *a = x + 2 * stride * p;
+                const float *b = x + 2 * stride * (p + half);
+                float *sum = y + 2 * stride * (2 * p);
+                float *diff = sum + 2 * stride;
+
+                for (int q = 0; q < 2 * stride; q += 2) {
+                    const float ar = a[q], ai = a[q + 1];
+                    const float br = b[q], bi = b[q + 1];
+                    const float dr = ar - br, di = ai - bi;
+
+                    sum[q] = ar + br;
+                    sum[q + 1] = ai + bi;
+                    // (a - b) * W
+                    diff[q] = dr * wr - di * wi;
+                    diff[q + 1] = dr * wi + di * wr;
+                }
+            }
+            std::swap(x, y);
+        }
+
+        // Odd number of stages leaves the result in the scratch buffer
+        if (x != fftBuffer) {
+            std::copy(x, x + 2 * n, fftBuffer);
+        }
+    }
+
+    void FftPlan::executeMixedRadix(float *fftBuffer, const int sign) const {
+        const auto fsign = static_cast<float>(sign);
+        float *x = fftBuffer;
+        float *y = scratch.data();
+        const float *stageCos = mixedCos.data();
+        const float *stageSin = mixedSin.data();
+
+        // Generalized Stockham: every length-len sub-transform with elements strided by stride is split into
+        // radix interleaved ones of length len/radix, y[q + s(p j + u)] = W_len^(j u) * DFT_p(x[q + s(j + r m)])_u
+        int len = n;
+        int stride = 1;
+        for (const int radix: radices) {
+            const int m = len / radix;
+
+            // W_p^t, exp(sign * 2πi t / p)
+            float rootCos[7];
+            float rootSin[7];
+            for (int t = 0; t < radix; ++t) {
+                const double angle = 2.0 * M_PI * static_cast<double>(t) / static_cast<double>(radix);
+                rootCos[t] = static_cast<float>(std::cos(angle));
+                rootSin[t] = fsign * static_cast<float>(std::sin(angle));
+            }
+
+            for (int j = 0; j < m; ++j) {
+                const float *twCos = stageCos + j * (radix - 1);
+                const float *twSin = stageSin + j * (radix - 1);
+
+                for (int q = 0; q < stride; ++q) {
+                    float ar[7];
+                    float ai[7];
+                    for (int r = 0; r < radix; ++r) {
+                        const int index = 2 * (q + stride * (j + r * m));
+                        ar[r] = x[index];
+                        ai[r] = x[index + 1];
+                    }
+
+                    float yr[7]{};
+                    float yi[7]{};
+                    if (radix == 2) {
+                        yr[0] = ar[0] + ar[1];
+                        yi[0] = ai[0] + ai[1];
+                        yr[1] = ar[0] - ar[1];
+                        yi[1] = ai[0] - ai[1];
+                    } else if (radix == 4) {
+                        const float acr = ar[0] + ar[2], aci = ai[0] + ai[2];
+                        const float amcr = ar[0] - ar[2], amci = ai[0] - ai[2];
+                        const float bdr = ar[1] + ar[3], bdi = ai[1] + ai[3];
+                        // (b - d) * (sign * i)
+                        const float jbdr = -fsign * (ai[1] - ai[3]), jbdi = fsign * (ar[1] - ar[3]);
+                        yr[0] = acr + bdr;
+                        yi[0] = aci + bdi;
+                        yr[1] = amcr + jbdr;
+                        yi[1] = amci + jbdi;
+                        yr[2] = acr - bdr;
+                        yi[2] = aci - bdi;
+                        yr[3] = amcr - jbdr;
+                        yi[3] = amci - jbdi;
+                    } else {
+                        for (int u = 0; u < radix; ++u) {
+                            float sr = 0.f;
+                            float si = 0.f;
+                            for (int r = 0; r < radix; ++r) {
+                                const int t = (r * u) % radix;
+                                sr += ar[r] * rootCos[t] - ai[r] * rootSin[t];
+                                si += ar[r] * rootSin[t] + ai[r] * rootCos[t];
+                            }
+                            yr[u] = sr;
+                            yi[u] = si;
+                        }
+                    }
+
+                    const int out = 2 * (q + stride * radix * j);
+                    y[out] = yr[0];
+                    y[out + 1] = yi[0];
+                    for (int u = 1; u < radix; ++u) {
+                        const float wr = twCos[u - 1];
+                        const float wi = fsign * twSin[u - 1];
+                        y[out + 2 * stride * u] = yr[u] * wr - yi[u] * wi;
+                        y[out + 2 * stride * u + 1] = yr[u] * wi + yi[u] * wr;
+                    }
+                }
+            }
+
+            stageCos += m * (radix - 1);
+            stageSin += m * (radix - 1);
+            std::swap(x, y);
+            len = m;
+            stride *= radix;
+        }
+
+        if (x != fftBuffer) {
+            std::copy(x, x + 2 * n, fftBuffer);
+        }
+    }
+
+    void FftPlan::executeBluestein(float *fftBuffer, const int sign) const {
+        const int innerSize = innerPlan->size();
+        float *a = scratch.data();
+
+        // The chirp is set up for the forward transform, the inverse is conj(FFT(conj(x)))
+        const float conjugate = sign > 0 ? -1.f : 1.f;
+
+        // a_k = x_k * chirp_k, zero-padded
+        for (int k = 0; k < n; ++k) {
+            const float xr = fftBuffer[2 * k];
+            const float xi = conjugate * fftBuffer[2 * k + 1];
+            const float cr = chirp[2 * k];
+            const float ci = chirp[2 * k + 1];
+            a[2 * k] = xr * cr - xi * ci;
+            a[2 * k + 1] = xr * ci + xi * cr;
+        }
+        std::fill(a + 2 * n, a + 2 * innerSize, 0.f);
+
+        // Circular convolution with the conjugate chirp
+        innerPlan->execute(a, -1);
+        for (int k = 0; k < innerSize; ++k) {
+            const float ar = a[2 * k];
+            const float ai = a[2 * k + 1];
+            const float br = chirpSpectrum[2 * k];
+            const float bi = chirpSpectrum[2 * k + 1];
+            a[2 * k] = ar * br - ai * bi;
+            a[2 * k + 1] = ar * bi + ai * br;
+        }
+        innerPlan->execute(a, 1);
+
+        // X_k = chirp_k * (a * conj chirp)_k
+        for (int k = 0; k < n; ++k) {
+            const float ar = a[2 * k];
+            const float ai = a[2 * k + 1];
+            const float cr = chirp[2 * k];
+            const float ci = chirp[2 * k + 1];
+            fftBuffer[2 * k] = ar * cr - ai * ci;
+            fftBuffer[2 * k + 1] = conjugate * (ar * ci + ai * cr);
+        }
+    }
+
+    void FftPlan::executeFourStep(float *fftBuffer, const int sign) const {
+        // x viewed as a rows x columns matrix, j = c + columns * r. With k = r' + rows * c':
+        // X[k] = sum_c W_columns^(c c') * W_N^(c r') * sum_r x[j] W_rows^(r r')
+        const int rows = fourStepRows;
+        const int columns = fourStepColumns;
+        const auto fsign = static_cast<float>(sign);
+        constexpr int tileColumns = 8;
+        const size_t tileSize = 2 * static_cast<size_t>(tileColumns) * rows;
+
+        // Sub-plans and tiles are per thread, grown on demand as OMP_NUM_THREADS may change between calls
+        const int threads = parallel ? omp_get_max_threads() : 1;
+        while (static_cast<int>(columnPlans.size()) < threads) {
+            columnPlans.push_back(std::make_unique<FftPlan>(rows, FftKernel::FixedSize));
+            rowPlans.push_back(std::make_unique<FftPlan>(columns, FftKernel::FixedSize));
+        }
+        if (tileScratch.size() < tileSize * threads) {
+            tileScratch.resize(tileSize * threads);
+        }
+
+        // Column FFTs, gathered a few columns at a time so each strided row access reads a whole cache line
+#pragma omp parallel for schedule(static) num_threads(threads) if (parallel)
+        for (int c0 = 0; c0 < columns; c0 += tileColumns) {
+            const int thread = parallel ? omp_get_thread_num() : 0;
+            float *tile = tileScratch.data() + tileSize * thread;
+            const FftPlan &columnPlan = *columnPlans[thread];
+            const int width = std::min(tileColumns, columns - c0);
+
+            for (int r = 0; r < rows; ++r) {
+                const float *source = fftBuffer + 2 * (static_cast<size_t>(r) * columns + c0);
+                for (int t = 0; t < width; ++t) {
+                    tile[2 * (static_cast<size_t>(t) * rows + r)] = source[2 * t];
+                    tile[2 * (static_cast<size_t>(t) * rows + r) + 1] = source[2 * t + 1];
+                }
+            }
+
+            for (int t = 0; t < width; ++t) {
+                float *column = tile + 2 * static_cast<size_t>(t) * rows;
+                columnPlan.execute(column, sign);
+
+                // Twiddles W_N^(c r') while the column is still in cache
+                const float *columnCos = fourStepCos.data() + static_cast<size_t>(c0 + t) * rows;
+                const float *columnSin = fourStepSin.data() + static_cast<size_t>(c0 + t) * rows;
+                for (int r = 0; r < rows; ++r) {
+                    const float wr = columnCos[r];
+                    const float wi = fsign * columnSin[r];
+                    const float xr = column[2 * r];
+                    const float xi = column[2 * r + 1];
+                    column[2 * r] = xr * wr - xi * wi;
+                    column[2 * r + 1] = xr * wi + xi * wr;
+                }
+            }
+
+            for (int r = 0; r < rows; ++r) {
+                float *destination = fftBuffer + 2 * (static_cast<size_t>(r) * columns + c0);
+                for (int t = 0; t < width; ++t) {
+                    destination[2 * t] = tile[2 * (static_cast<size_t>(t) * rows + r)];
+                    destination[2 * t + 1] = tile[2 * (static_cast<size_t>(t) * rows + r) + 1];
+                }
+            }
+        }
+
+        // Row FFTs on contiguous memory
+#pragma omp parallel for schedule(static) num_threads(threads) if (parallel)
+        for (int r = 0; r < rows; ++r) {
+            const int thread = parallel ? omp_get_thread_num() : 0;
+            rowPlans[thread]->execute(fftBuffer + 2 * static_cast<size_t>(r) * columns, sign);
+        }
+
+        // Element (r', c') belongs at r' + rows * c'
+        transposeComplex(fftBuffer, scratch.data(), rows, columns, parallel);
+        std::copy(scratch.data(), scratch.data() + 2 * static_cast<size_t>(n), fftBuffer);
+    }
+
+    RealFftPlan::RealFftPlan(const int fftFrameSize, const FftKernel kernel)
+        : n(fftFrameSize),
+          halfPlan(realHalfSize(fftFrameSize), kernel) {
+        const int half = n / 2;
+        twiddleCos.resize(half / 2 + 1);
+        twiddleSin.resize(half / 2 + 1);
+        for (int k = 0; k <= half / 2; ++k) {
+            const double angle = 2.0 * M_PI * static_cast<double>(k) / static_cast<double>(n);
+            twiddleCos[k] = static_cast<float>(std::cos(angle));
+            twiddleSin[k] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    void RealFftPlan::forward(float *buffer) const {
+        // Even samples become the real part, odd samples the imaginary part of a half-size signal z
+        halfPlan.execute(buffer, -1);
+        splitSpectrum(buffer);
+    }
+
+    void RealFftPlan::inverse(float *buffer) const {
+        mergeSpectrum(buffer);
+        halfPlan.execute(buffer, 1);
+    }
+
+    void RealFftPlan::forwardPruned(float *buffer, const int nonZeroInputs) const {
+        // Real sample j is part of complex sample j / 2 of the half-size signal
+        halfPlan.executePruned(buffer, -1, std::max(1, (nonZeroInputs + 1) / 2), n / 2);
+        splitSpectrum(buffer);
+    }
+
+    void RealFftPlan::inversePruned(float *buffer, const int usedOutputs) const {
+        mergeSpectrum(buffer);
+        halfPlan.executePruned(buffer, 1, n / 2, std::max(1, (usedOutputs + 1) / 2));
+    }
+
+    void RealFftPlan::forwardBatch(float *const *frames, const int count) const {
+        halfPlan.executeBatch(frames, count, -1);
+        for (int i = 0; i < count; ++i) {
+            splitSpectrum(frames[i]);
+        }
+    }
+
+    void RealFftPlan::inverseBatch(float *const *frames, const int count) const {
+        for (int i = 0; i < count; ++i) {
+            mergeSpectrum(frames[i]);
+        }
+        halfPlan.executeBatch(frames, count, 1);
+    }
+
+    void RealFftPlan::splitSpectrum(float *buffer) const {
+        const int half = n / 2;
+
+        // Z_N/2 == Z_0, both DC and Nyquist are purely real
+        const float z0r = buffer[0];
+        const float z0i = buffer[1];
+        buffer[0] = z0r + z0i;
+        buffer[1] = 0.f;
+        buffer[2 * half] = z0r - z0i;
+        buffer[2 * half + 1] = 0.f;
+
+        // Untangle the pair (k, N/2-k) at once:
+        // E = (Z_k + conj Z_{N/2-k}) / 2, O = -i (Z_k - conj Z_{N/2-k}) / 2, W = exp(-2πik/N)
+        // X_k = E + W O, X_{N/2-k} = conj(E - W O)
+        for (int k = 1; k <= half / 2; ++k) {
+            const int p1 = 2 * k;
+            const int p2 = 2 * (half - k);
+            const float ar = buffer[p1];
+            const float ai = buffer[p1 + 1];
+            const float br = buffer[p2];
+            const float bi = -buffer[p2 + 1];
+
+            const float er = 0.5f * (ar + br);
+            const float ei = 0.5f * (ai + bi);
+            const float or_ = 0.5f * (ai - bi);
+            const float oi = -0.5f * (ar - br);
+
+            const float wr = twiddleCos[k];
+            const float wi = -twiddleSin[k];
+            const float tr = wr * or_ - wi * oi;
+            const float ti = wr * oi + wi * or_;
+
+            buffer[p1] = er + tr;
+            buffer[p1 + 1] = ei + ti;
+            buffer[p2] = er - tr;
+            buffer[p2 + 1] = -(ei - ti);
+        }
+    }
+
+    void RealFftPlan::mergeSpectrum(float *buffer) const {
+        const int half = n / 2;
+
+        // Fold DC and Nyquist back into Z_0
+        const float x0 = buffer[0];
+        const float xn = buffer[2 * half];
+        buffer[0] = x0 + xn;
+        buffer[1] = x0 - xn;
+
+        // Inverse of the forward split, scaled by 2 so inverse(forward(x)) == N * x:
+        // E = X_k + conj X_{N/2-k}, O = (X_k - conj X_{N/2-k}) conj(W), Z_k = E + i O, Z_{N/2-k} = conj(E - i O)
+        for (int k = 1; k <= half / 2; ++k) {
+            const int p1 = 2 * k;
+            const int p2 = 2 * (half - k);
+            const float ar = buffer[p1];
+            const float ai = buffer[p1 + 1];
+            const float br = buffer[p2];
+            const float bi = -buffer[p2 + 1];
+
+            const float er = ar + br;
+            const float ei = ai + bi;
+            const float dr = ar - br;
+            const float di = ai - bi;
+
+            const float wr = twiddleCos[k];
+            const float wi = twiddleSin[k];
+            const float or_ = dr * wr - di * wi;
+            const float oi = dr * wi + di * wr;
+
+            buffer[p1] = er - oi;
+            buffer[p1 + 1] = ei + or_;
+            buffer[p2] = er + oi;
+            buffer[p2 + 1] = -(ei - or_);
+        }
+    }
+
+    namespace {
+        std::atomic<FftKernel> smbFftKernel{FftKernel::Auto};
+    }
+
+    void setSmbFftKernel(const FftKernel kernel) {
+        smbFftKernel.store(kernel);
+    }
+
+    FftKernel getSmbFftKernel() {
+        return smbFftKernel.load();
+    }
+
+    namespace {
+        // Plans are cached per thread so concurrent callers never share state
+        const FftPlan &cachedPlan(const int n) {
+            const FftKernel kernel = getSmbFftKernel();
+            // The parallel flag follows from the size, so it needs no bit of the key
+            const long long key = static_cast<long long>(n) * 16 + static_cast<int>(kernel);
+            thread_local std::unordered_map<long long, FftPlan> plans;
+            auto it = plans.find(key);
+            if (it == plans.end()) {
+                it = plans.emplace(key, FftPlan(n, kernel, n >= PARALLEL_FFT_MIN_SIZE)).first;
+            }
+            return it->second;
+        }
+    }
+
+    void smbFft(std::vector<float> &fftBuffer, const int fftFrameSize, const int sign) {
+        if (fftFrameSize <= 0) return;
+        const int n = fftFrameSize;
+        if (fftBuffer.size() < 2 * n) return;
+
+        // Specialized sizes need no plan lookup
+        if (getSmbFftKernel() == FftKernel::FixedSize && fixedSizeFft(fftBuffer.data(), n, sign)) return;
+        cachedPlan(n).execute(fftBuffer.data(), sign);
+    }
+
+    void fftBatch(std::vector<float> *frames, const int count, const int fftFrameSize, const int sign) {
+        if (fftFrameSize <= 0 || count <= 0) return;
+        const int n = fftFrameSize;
+
+        std::vector<float *> pointers;
+        pointers.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            if (frames[i].size() < 2 * n) return;
+            pointers.push_back(frames[i].data());
+        }
+        cachedPlan(n).executeBatch(pointers.data(), count, sign);
     }
-} // namespace BernseeFFT
+} // namespace p2t
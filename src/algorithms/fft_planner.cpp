@@ -0,0 +1,272 @@
+#include "pytotune/algorithms/fft_planner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "pytotune/algorithms/fixed_size_fft.h"
+
+namespace p2t {
+    namespace {
+        constexpr FftKernel PLANNABLE_KERNELS[] = {
+            FftKernel::Radix2, FftKernel::Simd, FftKernel::Radix4, FftKernel::Stockham, FftKernel::MixedRadix,
+            FftKernel::Bluestein, FftKernel::FixedSize, FftKernel::FourStep
+        };
+
+        /// CPU model and build options, the key under which this machine's wisdom is stored.
+        std::string machineTag() {
+            std::string model = "unknown";
+            std::ifstream cpuInfo("/proc/cpuinfo");
+            std::string line;
+            while (std::getline(cpuInfo, line)) {
+                if (line.rfind("model name", 0) == 0) {
+                    model = line.substr(line.find(':') + 2);
+                    break;
+                }
+            }
+#if USE_HWY
+            return model + " hwy=on";
+#else
+            return model + " hwy=off";
+#endif
+        }
+
+        std::string defaultWisdomPath() {
+            if (const char *path = std::getenv(FFT_WISDOM_ENV)) {
+                return path;
+            }
+            if (const char *home = std::getenv("HOME")) {
+                return std::string(home) + "/.pytotune_fft_wisdom";
+            }
+            return "";
+        }
+
+        std::optional<FftKernel> kernelFromName(const std::string &name) {
+            for (const auto kernel: PLANNABLE_KERNELS) {
+                if (name == fftKernelName(kernel)) return kernel;
+            }
+            return std::nullopt;
+        }
+
+        /// Kernels worth timing for a size; the others would replace themselves anyway.
+        std::vector<FftKernel> candidates(const int n) {
+            if ((n & (n - 1)) != 0) {
+                return {FftKernel::MixedRadix, FftKernel::Bluestein};
+            }
+            std::vector<FftKernel> kernels = {FftKernel::Radix2, FftKernel::Radix4, FftKernel::Stockham};
+#if USE_HWY
+            kernels.push_back(FftKernel::Simd);
+#endif
+            if (hasFixedSizeFft(n)) kernels.push_back(FftKernel::FixedSize);
+            if (n >= 4096) kernels.push_back(FftKernel::FourStep);
+            return kernels;
+        }
+
+        /// Best of a few rounds, each transforming about a million samples.
+        double secondsPerTransform(const FftPlan &plan) {
+            const int n = plan.size();
+            std::vector<float> buffer(2 * static_cast<size_t>(n));
+            for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = std::sin(0.01f * static_cast<float>(i));
+            plan.execute(buffer.data(), -1);
+
+            const int repetitions = std::max(1, (1 << 20) / n);
+            double best = 1e30;
+            for (int round = 0; round < 3; ++round) {
+                const auto start = std::chrono::steady_clock::now();
+                for (int r = 0; r < repetitions; ++r) {
+                    // Alternate directions so the values stay bounded up to a factor of n
+                    plan.execute(buffer.data(), (r & 1) ? 1 : -1);
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count() / repetitions);
+            }
+            return best;
+        }
+
+        FftKernel measure(const int n) {
+            const auto kernels = candidates(n);
+            FftKernel fastest = kernels.front();
+            double fastestSeconds = 1e30;
+            for (const auto kernel: kernels) {
+                const FftPlan plan(n, kernel);
+                // Skip kernels that replaced themselves, e.g. MixedRadix on sizes with large prime factors
+                if (plan.kernel() != kernel) continue;
+
+                const double seconds = secondsPerTransform(plan);
+                if (seconds < fastestSeconds) {
+                    fastestSeconds = seconds;
+                    fastest = kernel;
+                }
+            }
+            return fastest;
+        }
+
+        /// Name for a temporary file next to the wisdom file, unique across processes and threads.
+        std::string temporaryPath(const std::string &path) {
+            static std::random_device device;
+            std::ostringstream name;
+            name << path << '.' << getpid() << '.' << std::hex << device() << device() << ".tmp";
+            return name.str();
+        }
+
+        /**
+         * Wisdom of this machine, read from a file shared with other machines.
+         * One line per entry: "<machine tag>\t<size>\t<kernel name>".
+         */
+        struct Wisdom {
+            std::mutex mutex;
+            bool loaded = false;
+            std::string path;
+            std::string tag;
+            std::map<int, FftKernel> kernels;
+
+            void ensureLoaded() {
+                if (loaded) return;
+                loaded = true;
+                tag = machineTag();
+                if (path.empty()) path = defaultWisdomPath();
+                load();
+            }
+
+            void load() {
+                kernels.clear();
+                read(kernels, nullptr);
+            }
+
+            /// Parse the file into the entries of this machine and, if requested, the lines of the others.
+            void read(std::map<int, FftKernel> &own, std::vector<std::string> *foreignLines) const {
+                if (path.empty()) return;
+
+                std::ifstream file(path);
+                std::string line;
+                while (std::getline(file, line)) {
+                    std::istringstream fields(line);
+                    std::string lineTag, size, name;
+                    if (!std::getline(fields, lineTag, '\t') || !std::getline(fields, size, '\t') ||
+                        !std::getline(fields, name)) {
+                        continue;
+                    }
+                    if (lineTag != tag) {
+                        if (foreignLines) foreignLines->push_back(line);
+                        continue;
+                    }
+                    const auto kernel = kernelFromName(name);
+                    const int n = std::atoi(size.c_str());
+                    if (kernel && n > 0) own[n] = *kernel;
+                }
+            }
+
+            /**
+             * Write the wisdom merged with the current file contents, so entries
+             * other processes added since load() survive.
+             * @return False if the file could not be written.
+             */
+            bool store() {
+                if (path.empty()) return true;
+
+                std::map<int, FftKernel> stored;
+                std::vector<std::string> foreignLines;
+                read(stored, &foreignLines);
+                // Entries measured here win over the file for the same size
+                for (const auto &[n, kernel]: stored) kernels.emplace(n, kernel);
+
+                // Write a temporary file and rename it, so processes starting meanwhile never read half a file
+                const std::string temporary = temporaryPath(path);
+                {
+                    std::ofstream file(temporary, std::ios::trunc);
+                    for (const auto &line: foreignLines) file << line << '\n';
+                    for (const auto &[n, kernel]: kernels) file << tag << '\t' << n << '\t' << fftKernelName(kernel) << '\n';
+                    file.flush();
+                    if (!file) {
+                        std::remove(temporary.c_str());
+                        return false;
+                    }
+                }
+                if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+                    std::remove(temporary.c_str());
+                    return false;
+                }
+                return true;
+            }
+        };
+
+        Wisdom &wisdom() {
+            static Wisdom instance;
+            return instance;
+        }
+    }
+
+    FftKernel plannedFftKernel(const int n) {
+        Wisdom &w = wisdom();
+        std::lock_guard lock(w.mutex);
+        w.ensureLoaded();
+
+        if (const auto it = w.kernels.find(n); it != w.kernels.end()) {
+            return it->second;
+        }
+        // Timing every kernel inside a plan constructor is opt-in, otherwise unknown sizes take the default
+        if (!std::getenv(FFT_WISDOM_ENV)) {
+            return DEFAULT_FFT_KERNEL;
+        }
+        const FftKernel kernel = measure(n);
+        w.kernels[n] = kernel;
+        // A file that cannot be written only costs the measurement in the next process
+        w.store();
+        return kernel;
+    }
+
+    void tuneFft(const std::vector<int> &sizes) {
+        Wisdom &w = wisdom();
+        std::lock_guard lock(w.mutex);
+        w.ensureLoaded();
+
+        for (const int n: sizes) {
+            if (n > 0) w.kernels[n] = measure(n);
+        }
+        if (!w.store()) {
+            throw std::runtime_error("Cannot write FFT wisdom file: " + w.path);
+        }
+    }
+
+    std::optional<FftKernel> fftWisdom(const int n) {
+        Wisdom &w = wisdom();
+        std::lock_guard lock(w.mutex);
+        w.ensureLoaded();
+
+        if (const auto it = w.kernels.find(n); it != w.kernels.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    void setFftWisdomPath(const std::string &path) {
+        Wisdom &w = wisdom();
+        std::lock_guard lock(w.mutex);
+        w.tag = machineTag();
+        w.loaded = true;
+        w.path = path;
+        w.load();
+    }
+
+    std::string getFftWisdomPath() {
+        Wisdom &w = wisdom();
+        std::lock_guard lock(w.mutex);
+        w.ensureLoaded();
+        return w.path;
+    }
+}
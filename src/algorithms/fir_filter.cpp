@@ -0,0 +1,217 @@
+#include "pytotune/algorithms/fir_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "hwy/highway.h"
+#include "pytotune/algorithms/fft.h"
+
+using namespace hwy::HWY_NAMESPACE;
+
+namespace p2t {
+    namespace {
+        /// Largest overlap-save transform considered; longer blocks only add cache misses.
+        constexpr int MAX_OVERLAP_SAVE_FFT_SIZE = 1 << 15;
+
+        /// Power-of-two transform size with the fewest FFT operations per output sample.
+        int overlapSaveFftSize(const int branchTaps) {
+            int best = 64;
+            while (best < 2 * branchTaps) best *= 2;
+            double bestCost = 1e30;
+            for (int n = best; n <= std::max(best, MAX_OVERLAP_SAVE_FFT_SIZE); n *= 2) {
+                const double cost = n * std::log2(static_cast<double>(n)) / (n - branchTaps + 1);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = n;
+                }
+            }
+            return best;
+        }
+
+        /// Outputs per chunk of the Direct method; the phases of a chunk stay in the L1 or L2 cache.
+        constexpr int DIRECT_CHUNK_OUTPUTS = 2048;
+
+        /**
+         * Copy samples first .. first + count - 1 of input phase p, where sample i is
+         * input[i * factor + delay - p] and zero outside the input.
+         */
+        void loadPhase(const std::vector<float> &input, const long first, const int count, const int factor,
+                       const int delay, const int p, float *destination) {
+            const long offset = first * factor + delay - p;
+            const auto size = static_cast<long>(input.size());
+            // Samples [begin, end) lie inside the input and need no bounds checks
+            const long begin = std::clamp<long>(offset < 0 ? (-offset + factor - 1) / factor : 0, 0, count);
+            const long end = std::clamp<long>(size > offset ? (size - offset + factor - 1) / factor : 0, begin, count);
+
+            std::fill(destination, destination + begin, 0.0f);
+            const float *source = input.data() + (offset + begin * factor);
+            if (factor == 1) {
+                std::copy(source, source + (end - begin), destination + begin);
+            } else {
+                for (long i = begin; i < end; ++i, source += factor) destination[i] = *source;
+            }
+            std::fill(destination + end, destination + count, 0.0f);
+        }
+    }
+
+    FirFilter::FirFilter(std::vector<float> kernel, const int decimationFactor, const FirMethod method)
+        : kernel(std::move(kernel)), factor(decimationFactor) {
+        if (this->kernel.empty()) {
+            throw std::invalid_argument("FIR kernel must not be empty");
+        }
+        if (factor < 1) {
+            throw std::invalid_argument("Decimation factor must be at least 1 but got: " + std::to_string(factor));
+        }
+
+        const int taps = static_cast<int>(this->kernel.size());
+        branchTaps = (taps + factor - 1) / factor;
+        branchOffsets.push_back(0);
+        for (int p = 0; p < factor; ++p) {
+            for (int k = p; k < taps; k += factor) {
+                if (this->kernel[k] == 0.0f) continue;
+                tapDelays.push_back(k / factor);
+                tapValues.push_back(this->kernel[k]);
+            }
+            branchOffsets.push_back(static_cast<int>(tapDelays.size()));
+        }
+
+        firMethod = method;
+        if (firMethod == FirMethod::Auto) {
+            const auto nonZeroTaps = static_cast<int>(tapDelays.size());
+            firMethod = nonZeroTaps >= FIR_OVERLAP_SAVE_MIN_TAPS * factor ? FirMethod::OverlapSave : FirMethod::Direct;
+        }
+        if (firMethod != FirMethod::OverlapSave) return;
+
+        blockFftSize = overlapSaveFftSize(branchTaps);
+        const RealFftPlan plan(blockFftSize, FftKernel::Auto);
+        const size_t spectrumSize = blockFftSize + 2;
+        branchSpectra.assign(factor * spectrumSize, 0.0f);
+        for (int p = 0; p < factor; ++p) {
+            float *spectrum = branchSpectra.data() + p * spectrumSize;
+            // Fold the 1 / blockFftSize of the inverse transform into the kernel
+            for (int t = branchOffsets[p]; t < branchOffsets[p + 1]; ++t) {
+                spectrum[tapDelays[t]] = tapValues[t] / static_cast<float>(blockFftSize);
+            }
+            plan.forward(spectrum);
+        }
+    }
+
+    std::vector<float> FirFilter::apply(const std::vector<float> &input, const int delay) const {
+        if (input.size() < static_cast<size_t>(factor)) return {};
+        return firMethod == FirMethod::OverlapSave ? applyOverlapSave(input, delay) : applyDirect(input, delay);
+    }
+
+    std::vector<float> FirFilter::applyDirect(const std::vector<float> &input, const int delay) const {
+        const int outputSize = static_cast<int>(input.size() / factor);
+        const int chunks = (outputSize + DIRECT_CHUNK_OUTPUTS - 1) / DIRECT_CHUNK_OUTPUTS;
+        // Output m of branch p reads phase p at m - j for its taps j; every phase chunk holds
+        // branchTaps - 1 samples of history before its first output
+        const int phaseLength = DIRECT_CHUNK_OUTPUTS + branchTaps - 1;
+        std::vector<float> output(outputSize);
+
+#pragma omp parallel
+        {
+            std::vector<float> phases(static_cast<size_t>(factor) * phaseLength);
+
+#pragma omp for schedule(static)
+            for (int c = 0; c < chunks; ++c) {
+                const int first = c * DIRECT_CHUNK_OUTPUTS;
+                const int count = std::min(DIRECT_CHUNK_OUTPUTS, outputSize - first);
+                for (int p = 0; p < factor; ++p) {
+                    loadPhase(input, first - (branchTaps - 1), count + branchTaps - 1, factor, delay, p,
+                              phases.data() + static_cast<size_t>(p) * phaseLength);
+                }
+
+                int m = 0;
+# if USE_HWY
+                const ScalableTag<float> d;
+                const int lanes = static_cast<int>(Lanes(d));
+                const int block = 4 * lanes;
+
+                // Four output vectors per block, so every broadcast tap feeds four independent FMA chains
+                for (; m + block <= count; m += block) {
+                    auto acc0 = Zero(d);
+                    auto acc1 = Zero(d);
+                    auto acc2 = Zero(d);
+                    auto acc3 = Zero(d);
+                    for (int p = 0; p < factor; ++p) {
+                        const float *phase = phases.data() + static_cast<size_t>(p) * phaseLength + m + branchTaps - 1;
+                        for (int t = branchOffsets[p]; t < branchOffsets[p + 1]; ++t) {
+                            const auto tap = Set(d, tapValues[t]);
+                            const float *source = phase - tapDelays[t];
+                            acc0 = MulAdd(tap, LoadU(d, source), acc0);
+                            acc1 = MulAdd(tap, LoadU(d, source + lanes), acc1);
+                            acc2 = MulAdd(tap, LoadU(d, source + 2 * lanes), acc2);
+                            acc3 = MulAdd(tap, LoadU(d, source + 3 * lanes), acc3);
+                        }
+                    }
+                    float *destination = output.data() + first + m;
+                    StoreU(acc0, d, destination);
+                    StoreU(acc1, d, destination + lanes);
+                    StoreU(acc2, d, destination + 2 * lanes);
+                    StoreU(acc3, d, destination + 3 * lanes);
+                }
+# endif
+                // Scalar remainder (and full scalar path when USE_HWY=0)
+                for (; m < count; ++m) {
+                    float acc = 0.0f;
+                    for (int p = 0; p < factor; ++p) {
+                        const float *phase = phases.data() + static_cast<size_t>(p) * phaseLength + m + branchTaps - 1;
+                        for (int t = branchOffsets[p]; t < branchOffsets[p + 1]; ++t) {
+                            acc += tapValues[t] * phase[-tapDelays[t]];
+                        }
+                    }
+                    output[first + m] = acc;
+                }
+            }
+        }
+
+        return output;
+    }
+
+    std::vector<float> FirFilter::applyOverlapSave(const std::vector<float> &input, const int delay) const {
+        const int outputSize = static_cast<int>(input.size() / factor);
+        const int history = branchTaps - 1;
+        // The first branchTaps - 1 samples of every circular convolution wrap around and are discarded
+        const int blockOutputs = blockFftSize - history;
+        const int blocks = (outputSize + blockOutputs - 1) / blockOutputs;
+        const size_t spectrumSize = blockFftSize + 2;
+        std::vector<float> output(outputSize);
+
+#pragma omp parallel
+        {
+            // A plan owns its scratch space, so every thread transforms with its own
+            const RealFftPlan plan(blockFftSize, FftKernel::Auto);
+            std::vector<float> buffer(spectrumSize);
+            std::vector<float> sum(spectrumSize);
+
+#pragma omp for schedule(static)
+            for (int b = 0; b < blocks; ++b) {
+                const long first = static_cast<long>(b) * blockOutputs - history;
+                std::fill(sum.begin(), sum.end(), 0.0f);
+
+                for (int p = 0; p < factor; ++p) {
+                    loadPhase(input, first, blockFftSize, factor, delay, p, buffer.data());
+                    plan.forward(buffer.data());
+
+                    const float *spectrum = branchSpectra.data() + p * spectrumSize;
+                    for (int k = 0; k <= blockFftSize / 2; ++k) {
+                        const float re = buffer[2 * k], im = buffer[2 * k + 1];
+                        const float hRe = spectrum[2 * k], hIm = spectrum[2 * k + 1];
+                        sum[2 * k] += re * hRe - im * hIm;
+                        sum[2 * k + 1] += re * hIm + im * hRe;
+                    }
+                }
+
+                plan.inverse(sum.data());
+                const int start = b * blockOutputs;
+                const int count = std::min(blockOutputs, outputSize - start);
+                std::copy_n(sum.data() + history, count, output.data() + start);
+            }
+        }
+
+        return output;
+    }
+}
@@ -0,0 +1,270 @@
+#define _USE_MATH_DEFINES // Ensure M_PI is defined on MSVC
+#include "pytotune/algorithms/fixed_size_fft.h"
+
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace p2t {
+    namespace {
+        // std::sin and std::cos are not constexpr before C++26. The Taylor series is exact to double
+        // precision on [0, π], which covers every twiddle angle.
+        constexpr double constexprSin(const double x) {
+            double term = x;
+            double sum = x;
+            for (int i = 1; i < 20; ++i) {
+                term *= -x * x / static_cast<double>((2 * i) * (2 * i + 1));
+                sum += term;
+            }
+            return sum;
+        }
+
+        constexpr double constexprCos(const double x) {
+            double term = 1.0;
+            double sum = 1.0;
+            for (int i = 1; i < 20; ++i) {
+                term *= -x * x / static_cast<double>((2 * i - 1) * (2 * i));
+                sum += term;
+            }
+            return sum;
+        }
+
+        template<int N>
+        struct FixedFftTables {
+            /// bitReversal[i] is the bit-reversed index of complex sample i.
+            std::array<int, N> bitReversal{};
+            /// cos(2πk/le) and sin(2πk/le) for every stage le = 2..N, stored at offset le/2 - 1 like in FftPlan.
+            std::array<float, N> twiddleCos{};
+            std::array<float, N> twiddleSin{};
+        };
+
+        template<int N>
+        constexpr FixedFftTables<N> makeTables() {
+            FixedFftTables<N> tables;
+            int numStages = 0;
+            while ((1 << numStages) < N) ++numStages;
+
+            for (int i = 1; i < N; ++i) {
+                tables.bitReversal[i] = (tables.bitReversal[i >> 1] >> 1) | ((i & 1) << (numStages - 1));
+            }
+            for (int le = 2; le <= N; le <<= 1) {
+                const int le2 = le >> 1;
+                for (int k = 0; k < le2; ++k) {
+                    const double angle = 2.0 * M_PI * static_cast<double>(k) / static_cast<double>(le);
+                    tables.twiddleCos[le2 - 1 + k] = static_cast<float>(constexprCos(angle));
+                    tables.twiddleSin[le2 - 1 + k] = static_cast<float>(constexprSin(angle));
+                }
+            }
+            return tables;
+        }
+
+        template<int N>
+        constexpr FixedFftTables<N> FIXED_FFT_TABLES = makeTables<N>();
+
+        template<int N>
+        constexpr int log2Size() {
+            int stages = 0;
+            while ((1 << stages) < N) ++stages;
+            return stages;
+        }
+
+        /// One radix-2 stage of DFT length Le on bit-reversed input, computing the bins below usedOutputs of each block.
+        template<int N, int Le>
+        inline void radix2Stage(float *fftBuffer, const float fsign, const int usedOutputs = N) {
+            constexpr int le2 = Le / 2;
+            constexpr const float *stageCos = FIXED_FFT_TABLES<N>.twiddleCos.data() + le2 - 1;
+            constexpr const float *stageSin = FIXED_FFT_TABLES<N>.twiddleSin.data() + le2 - 1;
+
+            if (usedOutputs > le2) {
+                for (int k = 0; k < le2; ++k) {
+                    const float wr = stageCos[k];
+                    const float wi = fsign * stageSin[k];
+
+                    for (int blockStart = 0; blockStart < N; blockStart += Le) {
+                        const int p1 = 2 * (blockStart + k); // upper complex sample
+                        const int p2 = p1 + 2 * le2; // lower complex sample
+
+                        const float r2 = fftBuffer[p2];
+                        const float i2 = fftBuffer[p2 + 1];
+                        const float tr = r2 * wr - i2 * wi;
+                        const float ti = r2 * wi + i2 * wr;
+
+                        fftBuffer[p2] = fftBuffer[p1] - tr;
+                        fftBuffer[p2 + 1] = fftBuffer[p1 + 1] - ti;
+                        fftBuffer[p1] += tr;
+                        fftBuffer[p1 + 1] += ti;
+                    }
+                }
+                return;
+            }
+
+            // Powers of two: the lower half of every block lies past usedOutputs and is never read again
+            for (int k = 0; k < usedOutputs; ++k) {
+                const float wr = stageCos[k];
+                const float wi = fsign * stageSin[k];
+
+                for (int blockStart = 0; blockStart < N; blockStart += Le) {
+                    const int p1 = 2 * (blockStart + k);
+                    const int p2 = p1 + 2 * le2;
+
+                    const float r2 = fftBuffer[p2];
+                    const float i2 = fftBuffer[p2 + 1];
+                    fftBuffer[p1] += r2 * wr - i2 * wi;
+                    fftBuffer[p1 + 1] += r2 * wi + i2 * wr;
+                }
+            }
+        }
+
+        /// Bit-reverse and run the first two stages, which only use the twiddles 1 and ±i, as one radix-4 pass.
+        template<int N>
+        inline void bitReverseRadix4(float *fftBuffer, const float fsign) {
+            constexpr const int *bitReversal = FIXED_FFT_TABLES<N>.bitReversal.data();
+
+            for (int i = 0; i < N; ++i) {
+                const int j = bitReversal[i];
+                if (j > i) {
+                    std::swap(fftBuffer[2 * i], fftBuffer[2 * j]);
+                    std::swap(fftBuffer[2 * i + 1], fftBuffer[2 * j + 1]);
+                }
+            }
+
+            for (int i = 0; i < 2 * N; i += 8) {
+                float *x = fftBuffer + i;
+                const float t0r = x[0] + x[2], t0i = x[1] + x[3];
+                const float t1r = x[0] - x[2], t1i = x[1] - x[3];
+                const float t2r = x[4] + x[6], t2i = x[5] + x[7];
+                // (x2 - x3) * sign * i
+                const float t3r = -fsign * (x[5] - x[7]), t3i = fsign * (x[4] - x[6]);
+
+                x[0] = t0r + t2r;
+                x[1] = t0i + t2i;
+                x[2] = t1r + t3r;
+                x[3] = t1i + t3i;
+                x[4] = t0r - t2r;
+                x[5] = t0i - t2i;
+                x[6] = t1r - t3r;
+                x[7] = t1i - t3i;
+            }
+        }
+    }
+
+    template<int N>
+    void Fft<N>::transform(float *fftBuffer, const int sign) {
+        const auto fsign = static_cast<float>(sign);
+        bitReverseRadix4<N>(fftBuffer, fsign);
+
+        // Remaining stages le = 8..N, each with its own constant bounds
+        [&]<int... Stage>(std::integer_sequence<int, Stage...>) {
+            (radix2Stage<N, (8 << Stage)>(fftBuffer, fsign), ...);
+        }(std::make_integer_sequence<int, log2Size<N>() - 2>{});
+    }
+
+    template<int N>
+    void Fft<N>::transformPruned(float *fftBuffer, const int sign, const int nonZeroInputs, const int usedOutputs) {
+        const auto fsign = static_cast<float>(sign);
+        const int replicas = N / nonZeroInputs;
+        int firstStage = 8;
+
+        if (replicas == 1) {
+            bitReverseRadix4<N>(fftBuffer, fsign);
+        } else {
+            // Bit reversal moves input j < L to (N/L) * rev_L(j), followed by N/L - 1 zeros, and the stages
+            // up to N/L turn each such block into the input repeated. Permute the L inputs among themselves,
+            // then spread them from the top so no input is overwritten before it is read.
+            constexpr const int *bitReversal = FIXED_FFT_TABLES<N>.bitReversal.data();
+            for (int m = 0; m < nonZeroInputs; ++m) {
+                const int j = bitReversal[m * replicas];
+                if (j > m) {
+                    std::swap(fftBuffer[2 * m], fftBuffer[2 * j]);
+                    std::swap(fftBuffer[2 * m + 1], fftBuffer[2 * j + 1]);
+                }
+            }
+            for (int m = nonZeroInputs - 1; m >= 0; --m) {
+                const float real = fftBuffer[2 * m];
+                const float imag = fftBuffer[2 * m + 1];
+                for (int i = m * replicas; i < (m + 1) * replicas; ++i) {
+                    fftBuffer[2 * i] = real;
+                    fftBuffer[2 * i + 1] = imag;
+                }
+            }
+            firstStage = 2 * replicas;
+        }
+
+        // Stages le = 2..N, skipping those already covered above
+        [&]<int... Stage>(std::integer_sequence<int, Stage...>) {
+            (((2 << Stage) >= firstStage ? radix2Stage<N, (2 << Stage)>(fftBuffer, fsign, usedOutputs) : void()), ...);
+        }(std::make_integer_sequence<int, log2Size<N>()>{});
+    }
+
+    template struct Fft<64>;
+    template struct Fft<128>;
+    template struct Fft<256>;
+    template struct Fft<512>;
+    template struct Fft<1024>;
+    template struct Fft<2048>;
+    template struct Fft<4096>;
+    template struct Fft<8192>;
+
+    bool fixedSizeFft(float *fftBuffer, const int n, const int sign) {
+        switch (n) {
+            case 64:
+                Fft<64>::transform(fftBuffer, sign);
+                return true;
+            case 128:
+                Fft<128>::transform(fftBuffer, sign);
+                return true;
+            case 256:
+                Fft<256>::transform(fftBuffer, sign);
+                return true;
+            case 512:
+                Fft<512>::transform(fftBuffer, sign);
+                return true;
+            case 1024:
+                Fft<1024>::transform(fftBuffer, sign);
+                return true;
+            case 2048:
+                Fft<2048>::transform(fftBuffer, sign);
+                return true;
+            case 4096:
+                Fft<4096>::transform(fftBuffer, sign);
+                return true;
+            case 8192:
+                Fft<8192>::transform(fftBuffer, sign);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool fixedSizeFftPruned(float *fftBuffer, const int n, const int sign, const int nonZeroInputs,
+                            const int usedOutputs) {
+        switch (n) {
+            case 64:
+                Fft<64>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 128:
+                Fft<128>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 256:
+                Fft<256>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 512:
+                Fft<512>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 1024:
+                Fft<1024>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 2048:
+                Fft<2048>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 4096:
+                Fft<4096>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            case 8192:
+                Fft<8192>::transformPruned(fftBuffer, sign, nonZeroInputs, usedOutputs);
+                return true;
+            default:
+                return false;
+        }
+    }
+}
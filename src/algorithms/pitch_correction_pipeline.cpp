@@ -23,9 +23,11 @@ namespace p2t {
                                                               Windowing windowing,
                                                               PitchRange pitchRange,
                                                               float threshold,
-                                                              int decimationFactor) const {
+                                                              int decimationFactor,
+                                                              DifferenceMethod method,
+                                                              SearchMode mode) const {
         YINPitchDetector ypd(windowing);
-        return ypd.detectPitch(src.data(), pitchRange, threshold, decimationFactor);
+        return ypd.detectPitch(src.data(), pitchRange, threshold, decimationFactor, method, mode);
     }
 
     WavFile PitchCorrectionPipeline::shiftPitch(const WavFile &src,
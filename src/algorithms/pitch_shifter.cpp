@@ -8,6 +8,7 @@
 #include <string>
 
 #include "pytotune/algorithms/fft.h"
+#include "pytotune/algorithms/stft.h"
 
 namespace p2t {
     std::vector<float> PitchShifter::run(const std::vector<float> &samples, float pitchFactor) const {
@@ -23,138 +24,98 @@ namespace p2t {
                                         std::to_string(maxPitchFactor));
         }
 
-        const int bufferSize = static_cast<int>(std::pow(2, std::ceil(std::log2(maxPitchFactor)))) * 2 * windowing.
-                                windowSize;
         const int numWindows = samples.size() / windowing.stride;
 #ifdef REIMPLEMENTED_WINDOWING
-        std::vector<float> lastPhase(bufferSize / 2 + 1, 0.0f);
-        std::vector<float> sumPhase(bufferSize / 2 + 1, 0.0f);
-        std::vector<std::vector<float> > fftWorkspace(numWindows, std::vector<float>(2 * bufferSize));
-        std::vector<std::vector<float> > anaFreq(
-            numWindows, std::vector<float>(bufferSize));
-
-        std::vector<std::vector<float> > anaMagn(
-            numWindows, std::vector<float>(bufferSize));
+        const int numBins = windowing.windowSize / 2 + 1;
+        std::vector<float> lastPhase(numBins, 0.0f);
+        std::vector<float> sumPhase(numBins, 0.0f);
+        std::vector<std::vector<float> > fftWorkspace(numWindows, std::vector<float>(windowing.windowSize + 2));
         std::vector<float> outData(samples.size(), 0.0f);
 
         const float expect = 2.f * static_cast<float>(M_PI) * static_cast<float>(windowing.stride) / static_cast<float>(
                                  windowing.windowSize);
         const float freqPerBin = sampleRate / static_cast<float>(windowing.windowSize);
 
-#pragma omp parallel for ordered
-        for (int windowIndex = 0; windowIndex < numWindows; ++windowIndex) {
-            /* do windowing and re,im interleave */
-            for (int k = 0; k < windowing.windowSize; k++) {
-                if (windowIndex * windowing.stride + k >= samples.size()) break;
-                const float window = -.5f * std::cos(
-                                         2.f * static_cast<float>(M_PI) * static_cast<float>(k) / static_cast<float>(
-                                             windowing.windowSize)) + .5f;
-                fftWorkspace[windowIndex][2 * k] = samples[windowIndex * windowing.stride + k] * window;
-                fftWorkspace[windowIndex][2 * k + 1] = 0.;
-            }
-
-            /* ***************** ANALYSIS ******************* */
-            /* do transform */
-            p2t::smbFft(fftWorkspace[windowIndex], windowing.windowSize, -1);
+        /* windows are transformed in blocks so the batched FFT can put one window per SIMD lane */
+        constexpr int batchSize = 8;
+
+#pragma omp parallel
+        {
+            /* analyzers and synthesizers hold scratch space, so each thread builds its own */
+            const StftAnalyzer analyzer(windowing, sampleRate);
+            const StftSynthesizer synthesizer(windowing);
+            float *blockFrames[batchSize];
+            std::vector<float> gSynFreq(numBins);
+            std::vector<float> gSynMagn(numBins);
+
+#pragma omp for ordered schedule(static, 1)
+            for (int blockStart = 0; blockStart < numWindows; blockStart += batchSize) {
+                const int blockEnd = std::min(blockStart + batchSize, numWindows);
+                for (int windowIndex = blockStart; windowIndex < blockEnd; ++windowIndex) {
+                    blockFrames[windowIndex - blockStart] = fftWorkspace[windowIndex].data();
+                }
 
+                /* ***************** ANALYSIS ******************* */
+                /* window, transform and take magnitude and phase of the whole block */
+                analyzer.analyze(samples, blockStart, blockEnd - blockStart, blockFrames);
 
+                /* phases are tracked from window to window, so this part runs in window order */
 #pragma omp ordered
-            {
-                for (int k = 0; k <= windowing.windowSize / 2; k++) {
-                    /* de-interlace FFT buffer */
-                    const float real = fftWorkspace[windowIndex][2 * k];
-                    const float imag = fftWorkspace[windowIndex][2 * k + 1];
-
-                    /* compute magnitude and phase */
-                    float magn = 2. * sqrt(real * real + imag * imag);
-                    float phase = atan2(imag, real);
-
-                    /* compute phase difference */
-                    float tmp = phase - lastPhase[k];
-                    lastPhase[k] = phase;
+                for (int windowIndex = blockStart; windowIndex < blockEnd; ++windowIndex) {
+                    float *frame = fftWorkspace[windowIndex].data();
+                    analyzer.trueFrequency(frame, lastPhase.data());
+
+                    /* ***************** PROCESSING ******************* */
+                    /* this does the actual pitch shifting */
+                    std::fill(gSynFreq.begin(), gSynFreq.end(), 0.0f);
+                    std::fill(gSynMagn.begin(), gSynMagn.end(), 0.0f);
+                    const float factor = pitchFactors.data[windowIndex];
+                    for (int k = 0; k < numBins; k++) {
+                        int index = k * factor;
+                        if (index < numBins) {
+                            gSynMagn[index] += frame[2 * k];
+                            gSynFreq[index] = frame[2 * k + 1] * factor;
+                        }
+                    }
 
-                    /* subtract expected phase difference */
-                    tmp -= static_cast<float>(k) * expect;
+                    /* ***************** SYNTHESIS ******************* */
+                    /* this is the synthesis step, only bins 0..windowSize/2 reach the inverse transform */
+                    for (int k = 0; k < numBins; k++) {
+                        /* get magnitude and true frequency from synthesis arrays */
+                        float magn = gSynMagn[k];
+                        float tmp = gSynFreq[k];
 
-                    /* map delta phase into +/- Pi interval */
-                    int qpd = tmp / M_PI;
-                    if (qpd >= 0)
-                        qpd += qpd & 1;
-                    else
-                        qpd -= qpd & 1;
-                    tmp -= M_PI * (double) qpd;
+                        /* subtract bin mid frequency */
+                        tmp -= (double) k * freqPerBin;
 
-                    /* get deviation from bin frequency from the +/- Pi interval */
-                    tmp = static_cast<float>(windowing.getOsamp()) * tmp / static_cast<float>(2. * M_PI);
+                        /* get bin deviation from freq deviation */
+                        tmp /= freqPerBin;
 
-                    /* compute the k-th partials' true frequency */
-                    tmp = static_cast<float>(k) * freqPerBin + tmp * freqPerBin;
+                        /* take osamp into account */
+                        tmp = static_cast<float>(2. * M_PI) * tmp / static_cast<float>(windowing.getOsamp());
 
-                    /* store magnitude and true frequency in analysis arrays */
-                    anaMagn[windowIndex][k] = magn;
-                    anaFreq[windowIndex][k] = tmp;
-                }
-            }
+                        /* add the overlap phase advance back in */
+                        tmp += static_cast<float>(k) * expect;
 
+                        /* accumulate delta phase to get bin phase */
+                        sumPhase[k] += tmp;
 
-            /* ***************** PROCESSING ******************* */
-            /* this does the actual pitch shifting */
-            std::vector<float> gSynFreq(bufferSize, 0.0f);
-            std::vector<float> gSynMagn(bufferSize, 0.0f);
-            const float factor = pitchFactors.data[windowIndex];
-            for (int k = 0; k <= bufferSize / 2; k++) {
-                int index = k * factor;
-                if (index <= bufferSize / 2) {
-                    gSynMagn[index] += anaMagn[windowIndex][k];
-                    gSynFreq[index] = anaFreq[windowIndex][k] * factor;
+                        /* keep magnitude and phase, converted outside the ordered section */
+                        frame[2 * k] = magn;
+                        frame[2 * k + 1] = sumPhase[k];
+                    }
                 }
-            }
-
-            /* ***************** SYNTHESIS ******************* */
-            /* this is the synthesis step */
-            for (int k = 0; k <= bufferSize / 2; k++) {
-                /* get magnitude and true frequency from synthesis arrays */
-                float magn = gSynMagn[k];
-                float tmp = gSynFreq[k];
 
-                /* subtract bin mid frequency */
-                tmp -= (double) k * freqPerBin;
-
-                /* get bin deviation from freq deviation */
-                tmp /= freqPerBin;
-
-                /* take osamp into account */
-                tmp = static_cast<float>(2. * M_PI) * tmp / static_cast<float>(windowing.getOsamp());
-
-                /* add the overlap phase advance back in */
-                tmp += static_cast<float>(k) * expect;
-
-                /* accumulate delta phase to get bin phase */
-                sumPhase[k] += tmp;
-                float phase = sumPhase[k];
-
-                /* get real and imag part and re-interleave */
-                fftWorkspace[windowIndex][2 * k] = magn * std::cos(phase);
-                fftWorkspace[windowIndex][2 * k + 1] = magn * std::sin(phase);
+                /* inverse transform the whole block, kept until overlap-add */
+                synthesizer.synthesize(blockFrames, blockEnd - blockStart);
             }
 
-            /* zero negative frequencies */
-            for (int k = windowing.windowSize + 2; k < 2 * windowing.windowSize; k++)
-                fftWorkspace[windowIndex][k] = 0.;
-
-            /* do inverse transform */
-            smbFft(fftWorkspace[windowIndex], windowing.windowSize, 1);
-
-            for (int k = 0; k < windowing.windowSize; ++k) {
-                if (windowIndex * windowing.stride + k >= samples.size()) break;
-                float window =
-                        -0.5f * std::cos(2.0f * M_PI * k / windowing.windowSize) + 0.5f;
-
-#pragma omp atomic update
-                outData[windowIndex * windowing.stride + k] +=
-                        2.0f * window *
-                        fftWorkspace[windowIndex][2 * k] /
-                        static_cast<float>(windowing.windowSize / 2 * windowing.getOsamp());
+            /* overlap-add in rounds of windows that are far enough apart to never share an output sample */
+            for (int round = 0; round < synthesizer.overlapFrames(); ++round) {
+#pragma omp for schedule(static)
+                for (int windowIndex = round; windowIndex < numWindows; windowIndex += synthesizer.overlapFrames()) {
+                    synthesizer.overlapAdd(fftWorkspace[windowIndex].data(), windowIndex, outData);
+                }
             }
         }
 
@@ -162,9 +123,12 @@ namespace p2t {
 
 
 #else
+        const int bufferSize = static_cast<int>(std::pow(2, std::ceil(std::log2(maxPitchFactor)))) * 2 * windowing.
+                                windowSize;
+        const RealFftPlan fftPlan(windowing.windowSize, FftKernel::Auto);
         std::vector<float> inFifo(bufferSize, 0.0f);
         std::vector<float> outFifo(bufferSize, 0.0f);
-        std::vector<float> fftWorkspace(2 * bufferSize, 0.0f);
+        std::vector<float> fftWorkspace(windowing.windowSize + 2, 0.0f);
         std::vector<float> lastPhase(bufferSize / 2 + 1, 0.0f);
         std::vector<float> sumPhase(bufferSize / 2 + 1, 0.0f);
         std::vector<float> outputAccum(2 * bufferSize, 0.0f);
@@ -192,16 +156,15 @@ namespace p2t {
             if (rover >= windowing.windowSize) {
                 rover = inFifoLatency;
 
-                /* do windowing and re,im interleave */
+                /* do windowing */
                 for (int k = 0; k < windowing.windowSize; k++) {
                     float window = -.5f * cos(2. * M_PI * (double) k / (double) windowing.windowSize) + .5;
-                    fftWorkspace[2 * k] = inFifo[k] * window;
-                    fftWorkspace[2 * k + 1] = 0.;
+                    fftWorkspace[k] = inFifo[k] * window;
                 }
 
                 /* ***************** ANALYSIS ******************* */
-                /* do transform */
-                p2t::smbFft(fftWorkspace, windowing.windowSize, -1);
+                /* do real transform, yields bins 0..fftFrameSize2 */
+                fftPlan.forward(fftWorkspace.data());
 
                 /* this is the analysis step */
                 for (int k = 0; k <= fftFrameSize2; k++) {
@@ -280,16 +243,17 @@ namespace p2t {
                     fftWorkspace[2 * k + 1] = magn * sin(phase);
                 }
 
-                /* zero negative frequencies */
-                for (int k = windowing.windowSize + 2; k < 2 * windowing.windowSize; k++) fftWorkspace[k] = 0.;
+                /* the real inverse doubles bins 1..fftFrameSize2-1, so double the unpaired DC and Nyquist bins */
+                fftWorkspace[0] *= 2.f;
+                fftWorkspace[2 * fftFrameSize2] *= 2.f;
 
-                /* do inverse transform */
-                smbFft(fftWorkspace, windowing.windowSize, 1);
+                /* do inverse real transform */
+                fftPlan.inverse(fftWorkspace.data());
 
                 /* do windowing and add to output accumulator */
                 for (int k = 0; k < windowing.windowSize; k++) {
                     float window = -.5 * cos(2. * M_PI * (double) k / (double) windowing.windowSize) + .5;
-                    outputAccum[k] += 2. * window * fftWorkspace[2 * k] / (fftFrameSize2 * windowing.getOsamp());
+                    outputAccum[k] += window * fftWorkspace[k] / (fftFrameSize2 * windowing.getOsamp());
                 }
                 for (int k = 0; k < windowing.stride; k++) outFifo[k] = outputAccum[k];
 
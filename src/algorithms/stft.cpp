@@ -0,0 +1,135 @@
+#define _USE_MATH_DEFINES // Ensure M_PI is defined on MSVC
+#include "pytotune/algorithms/stft.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace p2t {
+    namespace {
+        /// Hann window of the given size, as used throughout the phase vocoder.
+        std::vector<float> hannWindow(const int size) {
+            std::vector<float> window(size);
+            for (int k = 0; k < size; ++k) {
+                window[k] = static_cast<float>(-.5 * std::cos(2. * M_PI * k / size) + .5);
+            }
+            return window;
+        }
+
+        Windowing validated(const Windowing windowing) {
+            windowing.validateForFft();
+            return windowing;
+        }
+    }
+
+    StftAnalyzer::StftAnalyzer(const Windowing windowing, const float sampleRate)
+        : windowing(validated(windowing)),
+          fftPlan(windowing.windowSize, FftKernel::Auto),
+          window(hannWindow(windowing.windowSize)),
+          expect(2.f * static_cast<float>(M_PI) * static_cast<float>(windowing.stride) /
+                 static_cast<float>(windowing.windowSize)),
+          freqPerBin(sampleRate / static_cast<float>(windowing.windowSize)) {
+    }
+
+    void StftAnalyzer::analyze(const std::vector<float> &samples, const int firstFrame, const int count,
+                               float *const *frames) const {
+        const int windowSize = windowing.windowSize;
+
+        /* load with the window applied, zero past the end of the input */
+        for (int f = 0; f < count; ++f) {
+            const size_t start = static_cast<size_t>(firstFrame + f) * windowing.stride;
+            const int available = start < samples.size()
+                                      ? static_cast<int>(std::min<size_t>(windowSize, samples.size() - start))
+                                      : 0;
+            float *frame = frames[f];
+            for (int k = 0; k < available; ++k) {
+                frame[k] = samples[start + k] * window[k];
+            }
+            std::fill(frame + available, frame + windowSize, 0.f);
+        }
+
+        /* one window per SIMD lane where possible, yields bins 0..windowSize/2 */
+        fftPlan.forwardBatch(frames, count);
+
+        /* magnitude and phase while the frame is still in cache */
+        for (int f = 0; f < count; ++f) {
+            float *frame = frames[f];
+            for (int k = 0; k <= windowSize / 2; ++k) {
+                const float real = frame[2 * k];
+                const float imag = frame[2 * k + 1];
+                frame[2 * k] = 2.f * std::sqrt(real * real + imag * imag);
+                frame[2 * k + 1] = std::atan2(imag, real);
+            }
+        }
+    }
+
+    void StftAnalyzer::trueFrequency(float *frame, float *lastPhase) const {
+        const auto osamp = static_cast<float>(windowing.getOsamp());
+
+        for (int k = 0; k <= windowing.windowSize / 2; ++k) {
+            const float phase = frame[2 * k + 1];
+
+            /* compute phase difference */
+            float tmp = phase - lastPhase[k];
+            lastPhase[k] = phase;
+
+            /* subtract expected phase difference */
+            tmp -= static_cast<float>(k) * expect;
+
+            /* map delta phase into +/- Pi interval */
+            int qpd = static_cast<int>(tmp / M_PI);
+            if (qpd >= 0)
+                qpd += qpd & 1;
+            else
+                qpd -= qpd & 1;
+            tmp = static_cast<float>(tmp - M_PI * static_cast<double>(qpd));
+
+            /* get deviation from bin frequency from the +/- Pi interval */
+            tmp = osamp * tmp / static_cast<float>(2. * M_PI);
+
+            /* compute the k-th partials' true frequency */
+            frame[2 * k + 1] = static_cast<float>(k) * freqPerBin + tmp * freqPerBin;
+        }
+    }
+
+    StftSynthesizer::StftSynthesizer(const Windowing windowing)
+        : windowing(validated(windowing)),
+          fftPlan(windowing.windowSize, FftKernel::Auto),
+          scaledWindow(hannWindow(windowing.windowSize)) {
+        const auto scale = static_cast<float>(windowing.windowSize / 2 * windowing.getOsamp());
+        for (auto &w: scaledWindow) w /= scale;
+    }
+
+    void StftSynthesizer::synthesize(float *const *frames, const int count) const {
+        const int windowSize = windowing.windowSize;
+
+        for (int f = 0; f < count; ++f) {
+            float *frame = frames[f];
+
+            /* get real and imag part and re-interleave */
+            for (int k = 0; k <= windowSize / 2; ++k) {
+                const float magn = frame[2 * k];
+                const float phase = frame[2 * k + 1];
+                frame[2 * k] = magn * std::cos(phase);
+                frame[2 * k + 1] = magn * std::sin(phase);
+            }
+
+            /* the real inverse mirrors bins 1..windowSize/2-1 onto the negative frequencies,
+             * which doubles them, so double the unpaired DC and Nyquist bins to match */
+            frame[0] *= 2.f;
+            frame[windowSize] *= 2.f;
+        }
+
+        fftPlan.inverseBatch(frames, count);
+    }
+
+    void StftSynthesizer::overlapAdd(const float *frame, const int frameIndex, const std::span<float> output) const {
+        const size_t start = static_cast<size_t>(frameIndex) * windowing.stride;
+        if (start >= output.size()) return;
+
+        const int length = static_cast<int>(std::min<size_t>(windowing.windowSize, output.size() - start));
+        float *destination = output.data() + start;
+        for (int k = 0; k < length; ++k) {
+            destination[k] += scaledWindow[k] * frame[k];
+        }
+    }
+}
@@ -1,123 +1,391 @@
 #include "../../include/pytotune/algorithms/yin_pitch_detector.h"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <string>
 
 #include <cmath>
-#include "hwy/highway.h"
 #include "hwy/aligned_allocator.h"
+#include "hwy/highway.h"
+#include "pytotune/algorithms/fft.h"
+#include "pytotune/algorithms/fir_filter.h"
 
 using namespace hwy::HWY_NAMESPACE;
 
 namespace p2t {
-    WindowedData<float> YINPitchDetector::detectPitch(const WavData &audioBuffer, const PitchRange pitchRange,
-                                                      const float threshold, const int decimationFactor) const {
-        std::vector<float> downsampledAudio =
-                decimateZeroPhase(audioBuffer.samples, decimationFactor);
+    namespace {
+        /// Auto uses the Fft method from this many taus per stage of the padded transform on, see resolveDifferenceMethod().
+        constexpr int FFT_DIFFERENCE_TAUS_PER_STAGE = 4;
+
+        /// Shortest and longest half-band stage of the decimation cascade, both of the form 4k + 3 so the outer taps are non-zero.
+        constexpr int HALFBAND_MIN_TAPS = 7;
+        constexpr int HALFBAND_MAX_TAPS = 255;
+        /// Frequencies at which the passband of a decimation filter is checked.
+        constexpr int PASSBAND_GRID_POINTS = 128;
+        /// Frequencies at which the stopband of a half-band stage is checked, dense enough to hit every sidelobe.
+        constexpr int STOPBAND_GRID_POINTS = 512;
+        /// Margin of the Kaiser window over DECIMATION_STOPBAND_DB, so the sidelobes stay below it at any length.
+        constexpr float KAISER_MARGIN_DB = 10.0f;
+
+        /// Amplitude response in dB of a symmetric FIR at a frequency in cycles per sample.
+        float responseDb(const std::vector<float> &kernel, const float frequency) {
+            const double center = static_cast<double>(kernel.size() - 1) / 2.0;
+            double response = 0.0;
+            for (size_t n = 0; n < kernel.size(); ++n) {
+                response += kernel[n] * std::cos(2.0 * M_PI * frequency * (static_cast<double>(n) - center));
+            }
+            return static_cast<float>(20.0 * std::log10(std::max(std::abs(response), 1e-30)));
+        }
 
-        const unsigned int downsampledFs =
-                audioBuffer.sampleRate / decimationFactor;
+        /// Check that a symmetric FIR deviates by at most toleranceDb from unity on [0, edge].
+        bool withinTolerance(const std::vector<float> &kernel, const float edge, const float toleranceDb) {
+            for (int i = 0; i <= PASSBAND_GRID_POINTS; ++i) {
+                const float frequency = edge * static_cast<float>(i) / PASSBAND_GRID_POINTS;
+                if (std::abs(responseDb(kernel, frequency)) > toleranceDb) return false;
+            }
+            return true;
+        }
 
-        const unsigned int tauMin = downsampledFs / static_cast<int>(pitchRange.max);
-        const unsigned int tauMax = downsampledFs / static_cast<int>(pitchRange.min);
+        /// Check that a symmetric FIR attenuates [from, 0.5] by at least rejectionDb.
+        bool withinStopband(const std::vector<float> &kernel, const float from, const float rejectionDb) {
+            for (int i = 0; i <= STOPBAND_GRID_POINTS; ++i) {
+                const float frequency = from + (0.5f - from) * static_cast<float>(i) / STOPBAND_GRID_POINTS;
+                if (responseDb(kernel, frequency) > -rejectionDb) return false;
+            }
+            return true;
+        }
 
-        const unsigned int numWindows = (downsampledAudio.size() - this->windowing.windowSize) / this->windowing.
-                                        stride + 1;
-        std::vector<float> pitchValues(numWindows);
-#pragma omp parallel for schedule(dynamic, 16)
-        // prevent false sharing of pitchValues by using dynamic scheduling with small chunks
-        for (int i = 0; i < numWindows; i++) {
-            // Process each window
-            const int windowStart = i * this->windowing.stride;
-            const int windowEnd = std::min(windowStart + this->windowing.windowSize,
-                                           static_cast<int>(downsampledAudio.size()));
-            std::vector<float> windowSamples(
-                downsampledAudio.begin() + windowStart,
-                downsampledAudio.begin() + windowEnd);
-
-            // --- Silence / low-energy detection ---
-            float energy = 0.0f;
-            for (float f: windowSamples) {
-                energy += f * f;
-            }
-            energy /= windowSamples.size(); // mean square
-
-            constexpr float silenceThreshold = 1e-6f;
-
-            if (energy < silenceThreshold) {
-                pitchValues[i] = 0.0f; // 0 Hz = unvoiced
-                continue;
-            }
-
-            std::vector<float> diff(tauMax + 1);
-            for (unsigned int tau = tauMin; tau <= tauMax; ++tau) {
-                // computation of sum_{j=0}^{N-1} (x[j] - x[j+tau])^2
-                size_t k = 0;
-                const float *aPtr = windowSamples.data();
-                const float *bPtr = aPtr + tau;
-                float sum = 0.0f;
-                const size_t n = (windowSamples.size() > tau) ? (windowSamples.size() - tau) : 0;
-                if (n > 0) {
+        /// Modified Bessel function of the first kind and order zero, by its power series.
+        double besselI0(const double x) {
+            double sum = 1.0;
+            double term = 1.0;
+            for (int k = 1; term > 1e-12 * sum; ++k) {
+                const double half = x / (2.0 * k);
+                term *= half * half;
+                sum += term;
+            }
+            return sum;
+        }
+
+        /// Highest frequency up to which a symmetric lowpass FIR stays within toleranceDb of unity.
+        float passbandEdge(const std::vector<float> &kernel, const float toleranceDb) {
+            constexpr float step = 0.5f / (16 * PASSBAND_GRID_POINTS);
+            float frequency = 0.0f;
+            while (frequency + step < 0.5f && std::abs(responseDb(kernel, frequency + step)) <= toleranceDb) {
+                frequency += step;
+            }
+            return frequency;
+        }
+
+        /// Taus computed together by the tiled kernel, each with its own accumulator register.
+        constexpr unsigned int DIFFERENCE_TAU_BLOCK = 4;
+
+        /// Add (x[j] - x[j+tau])^2 for j in [begin, end) to sum, scalar.
+        inline float addSquaredDifferences(const float *samples, const unsigned int tau, size_t begin,
+                                           const size_t end, float sum) {
+            for (; begin < end; ++begin) {
+                const float delta = samples[begin] - samples[begin + tau];
+                sum += delta * delta;
+            }
+            return sum;
+        }
+
+        /**
+         * Register-tiled kernel: sums[t] = sum_{j<n} (fixed[j] - shifted[j + t * step])^2 for the
+         * DIFFERENCE_TAU_BLOCK offsets t. Each loaded vector of fixed is reused for every offset,
+         * the accumulators stay in registers and are reduced once at the end.
+         * @return Number of leading j covered by the vector loop; the caller adds the rest.
+         */
+        inline size_t tiledSquaredDifferences(const float *fixed, const float *shifted, const int step,
+                                              const size_t n, float *sums) {
+            size_t k = 0;
 # if USE_HWY
-                    // Vectorized computation using Highway
-                    ScalableTag<float> d;
-                    auto vecAcc = Set(d, 0.0f);
-                    const size_t lanes = Lanes(d);
-
-                    for (; k + lanes <= n; k += lanes) {
-                        const auto va = Load(d, aPtr + k);
-                        const auto vb = Load(d, bPtr + k);
-                        const auto diffv = va - vb;
-                        vecAcc = vecAcc + diffv * diffv;
-                    }
+            const ScalableTag<float> d;
+            const size_t lanes = Lanes(d);
+            auto acc0 = Zero(d);
+            auto acc1 = Zero(d);
+            auto acc2 = Zero(d);
+            auto acc3 = Zero(d);
+
+            for (; k + lanes <= n; k += lanes) {
+                const auto va = LoadU(d, fixed + k);
+                const auto d0 = va - LoadU(d, shifted + k);
+                const auto d1 = va - LoadU(d, shifted + k + step);
+                const auto d2 = va - LoadU(d, shifted + k + 2 * step);
+                const auto d3 = va - LoadU(d, shifted + k + 3 * step);
+                acc0 = MulAdd(d0, d0, acc0);
+                acc1 = MulAdd(d1, d1, acc1);
+                acc2 = MulAdd(d2, d2, acc2);
+                acc3 = MulAdd(d3, d3, acc3);
+            }
 
-                    // Horizontal reduce SIMD accumulator into scalar sum
-                    std::vector<float> tmp(lanes);
-                    Store(vecAcc, d, tmp.data());
-                    for (size_t i = 0; i < lanes; ++i) sum += tmp[i];
+            sums[0] = GetLane(SumOfLanes(d, acc0));
+            sums[1] = GetLane(SumOfLanes(d, acc1));
+            sums[2] = GetLane(SumOfLanes(d, acc2));
+            sums[3] = GetLane(SumOfLanes(d, acc3));
+# else
+            std::fill_n(sums, DIFFERENCE_TAU_BLOCK, 0.0f);
+            for (; k < n; ++k) {
+                for (unsigned int t = 0; t < DIFFERENCE_TAU_BLOCK; ++t) {
+                    const float delta = fixed[k] - shifted[k + t * step];
+                    sums[t] += delta * delta;
+                }
+            }
 # endif
-                    // Collect remaining elements
-                    for (; k < n; ++k) {
-                        const float delta = aPtr[k] - bPtr[k];
-                        sum += delta * delta;
+            return k;
+        }
+
+        /**
+         * Computation of sum_{j=0}^{N-1-tau} (x[j] - x[j+tau])^2 for every tau in [tauMin, tauMax],
+         * in blocks of DIFFERENCE_TAU_BLOCK taus. The tiled loop covers the pairs every tau of the
+         * block has, scalar tails the rest.
+         */
+        void directDifference(const float *samples, const int size, const unsigned int tauMin,
+                              const unsigned int tauMax, float *diff) {
+            const auto count = static_cast<unsigned int>(size);
+            unsigned int tau = tauMin;
+            float sums[DIFFERENCE_TAU_BLOCK];
+
+            for (; tau + DIFFERENCE_TAU_BLOCK - 1 <= tauMax && tau + DIFFERENCE_TAU_BLOCK - 1 < count;
+                   tau += DIFFERENCE_TAU_BLOCK) {
+                const size_t n = count - (tau + DIFFERENCE_TAU_BLOCK - 1);
+                const size_t covered = tiledSquaredDifferences(samples, samples + tau, 1, n, sums);
+                for (unsigned int t = 0; t < DIFFERENCE_TAU_BLOCK; ++t) {
+                    diff[tau + t] = addSquaredDifferences(samples, tau + t, covered, count - tau - t, sums[t]);
+                }
+            }
+            for (; tau <= tauMax; ++tau) {
+                diff[tau] = count > tau ? addSquaredDifferences(samples, tau, 0, count - tau, 0.0f) : 0.0f;
+            }
+        }
+
+        /**
+         * Difference function via the autocorrelation, d(tau) = r_t(0) + r_{t+tau}(0) - 2 r_t(tau).
+         *
+         * The window is zero-padded to a power of two of at least windowSize + tauMax samples,
+         * so the circular autocorrelation equals the linear one for every tau up to tauMax.
+         * Owns FFT scratch space, so each thread needs its own instance.
+         */
+        class FftDifference {
+        public:
+            FftDifference(const int windowSize, const unsigned int tauMax)
+                : plan(paddedSize(windowSize, tauMax), FftKernel::Auto),
+                  buffer(plan.size() + 2) {
+            }
+
+            /// @param squares Prefix sums of squares of the signal from the window start on, see prefixSquares.
+            void compute(const float *samples, const double *squares, const int size, const unsigned int tauMin,
+                         const unsigned int tauMax, float *diff) {
+                std::copy_n(samples, size, buffer.begin());
+                std::fill(buffer.begin() + size, buffer.end(), 0.0f);
+                plan.forwardPruned(buffer.data(), size);
+
+                // Power spectrum, whose inverse transform is the autocorrelation
+                for (size_t k = 0; k < buffer.size(); k += 2) {
+                    buffer[k] = buffer[k] * buffer[k] + buffer[k + 1] * buffer[k + 1];
+                    buffer[k + 1] = 0.0f;
+                }
+                plan.inversePruned(buffer.data(), static_cast<int>(tauMax) + 1);
+
+                const double scale = 1.0 / plan.size();
+                for (unsigned int tau = tauMin; tau <= tauMax; ++tau) {
+                    if (tau >= static_cast<unsigned int>(size)) {
+                        diff[tau] = 0.0f;
+                        continue;
                     }
+                    // r_t(0) + r_{t+tau}(0) over the pairs of d(tau)
+                    const double energy = (squares[size - tau] - squares[0]) + (squares[size] - squares[tau]);
+                    const double value = energy - 2.0 * scale * buffer[tau];
+                    diff[tau] = static_cast<float>(std::max(value, 0.0));
                 }
-                diff[tau] = sum;
             }
 
-            // CMND (Cumulative Mean Normalized Difference Function)
-            std::vector<float> cmnd(tauMax + 1);
-            float runningSum = 1.0f;
-            for (int tau = 1; tau <= tauMax; ++tau) {
+        private:
+            RealFftPlan plan;
+            std::vector<float> buffer;
+
+            static int paddedSize(const int windowSize, const unsigned int tauMax) {
+                int size = 2;
+                while (size < windowSize + static_cast<int>(tauMax)) size <<= 1;
+                return size;
+            }
+        };
+
+        /**
+         * Difference function updated from the one of the previous window.
+         *
+         * With the window moving from s to s + stride, d(tau) gains the terms
+         * (x[j] - x[j+tau])^2 for j in [s + W - tau, s + stride + W - tau) and loses those
+         * for j in [s, s + stride). The sums are kept in double so the updates of a run of
+         * windows do not drift. Windows that do not follow the previous one, e.g. after a
+         * silent window or at the start of a thread's run, are computed directly.
+         */
+        class IncrementalDifference {
+        public:
+            IncrementalDifference(const int stride, const unsigned int tauMax) : stride(stride), sums(tauMax + 1) {
+            }
+
+            /// @param samples Window start inside the signal; the stride before it must be readable when
+            ///                this window directly follows the previous call.
+            void compute(const float *samples, const int windowStart, const int size, const unsigned int tauMin,
+                         const unsigned int tauMax, float *diff) {
+                const bool follows = valid && windowStart == lastStart + stride && size == lastSize &&
+                                     static_cast<unsigned int>(size) > tauMax + stride;
+                lastStart = windowStart;
+                lastSize = size;
+                valid = true;
+
+                if (!follows) {
+                    directDifference(samples, size, tauMin, tauMax, diff);
+                    for (unsigned int tau = tauMin; tau <= tauMax; ++tau) sums[tau] = diff[tau];
+                    return;
+                }
+
+                // Entering pairs are (x[e - tau + j], x[e + j]) with e = size - stride, leaving pairs
+                // (p[j], p[j + tau]) with p the previous window: one side is the same for every tau
+                const float *previous = samples - stride;
+                const float *enteringEnd = samples + (size - stride);
+                float gained[DIFFERENCE_TAU_BLOCK];
+                float lost[DIFFERENCE_TAU_BLOCK];
+                unsigned int tau = tauMin;
+                for (; tau + DIFFERENCE_TAU_BLOCK - 1 <= tauMax; tau += DIFFERENCE_TAU_BLOCK) {
+                    const size_t covered = tiledSquaredDifferences(enteringEnd, enteringEnd - tau, -1, stride, gained);
+                    tiledSquaredDifferences(previous, previous + tau, 1, stride, lost);
+                    for (unsigned int t = 0; t < DIFFERENCE_TAU_BLOCK; ++t) {
+                        gained[t] = addSquaredDifferences(enteringEnd - (tau + t), tau + t, covered, stride, gained[t]);
+                        lost[t] = addSquaredDifferences(previous, tau + t, covered, stride, lost[t]);
+                        update(tau + t, gained[t], lost[t], diff);
+                    }
+                }
+                for (; tau <= tauMax; ++tau) {
+                    update(tau, addSquaredDifferences(enteringEnd - tau, tau, 0, stride, 0.0f),
+                           addSquaredDifferences(previous, tau, 0, stride, 0.0f), diff);
+                }
+            }
+
+        private:
+            int stride;
+            std::vector<double> sums;
+
+            void update(const unsigned int tau, const float gained, const float lost, float *diff) {
+                sums[tau] += static_cast<double>(gained) - static_cast<double>(lost);
+                diff[tau] = static_cast<float>(std::max(sums[tau], 0.0));
+            }
+
+            bool valid = false;
+            int lastStart = 0;
+            int lastSize = 0;
+        };
+
+        /**
+         * Pick the method for Auto. Direct costs about windowSize multiply-adds per tau, the
+         * transforms about 5 * paddedSize * log2(paddedSize) flops per window in total, which is
+         * amortized after a number of taus growing with log2(paddedSize).
+         */
+        DifferenceMethod resolveDifferenceMethod(const DifferenceMethod method, const Windowing &windowing,
+                                                 const unsigned int tauMin, const unsigned int tauMax) {
+            if (method != DifferenceMethod::Auto) return method;
+            const int tauRange = static_cast<int>(tauMax - tauMin) + 1;
+            int stages = 1;
+            while ((1 << stages) < windowing.windowSize + static_cast<int>(tauMax)) ++stages;
+            if (tauRange >= FFT_DIFFERENCE_TAUS_PER_STAGE * stages) return DifferenceMethod::Fft;
+            // An update touches 2 * stride pairs per tau against windowSize for a direct pass
+            return 2 * windowing.stride < windowing.windowSize ? DifferenceMethod::Incremental : DifferenceMethod::Direct;
+        }
+
+        /// Windows with a mean square below this are unvoiced.
+        constexpr double SILENCE_THRESHOLD = 1e-6;
+
+        /**
+         * Prefix sums of squares, squares[k] = sum_{j<k} signal[j]^2, in double as d(tau) cancels most of
+         * the energy terms. Any window's energy is then a difference of two entries.
+         */
+        std::vector<double> prefixSquares(const std::vector<float> &signal) {
+            std::vector<double> squares(signal.size() + 1);
+            for (size_t j = 0; j < signal.size(); ++j) {
+                squares[j + 1] = squares[j] + static_cast<double>(signal[j]) * signal[j];
+            }
+            return squares;
+        }
+
+        /**
+         * Silence / low-energy detection in O(1).
+         * @param squares Prefix sums of squares from the window start on.
+         */
+        bool isSilent(const double *squares, const int size) {
+            return squares[size] - squares[0] < SILENCE_THRESHOLD * size;
+        }
+
+        /**
+         * Per-thread scratch space of one detection run: d(tau) and the CMND for tau up to tauMax + 1,
+         * allocated once and aligned for SIMD loads, so no window allocates. The window samples are
+         * read in place from the signal.
+         */
+        class DifferenceScratch {
+        public:
+            explicit DifferenceScratch(const unsigned int tauMax)
+                : stride(paddedSize(tauMax + 2)),
+                  storage(hwy::AllocateAligned<float>(2 * stride)) {
+                std::fill_n(storage.get(), 2 * stride, 0.0f);
+            }
+
+            [[nodiscard]] float *diff() const {
+                return storage.get();
+            }
+
+            [[nodiscard]] float *cmnd() const {
+                return storage.get() + stride;
+            }
+
+        private:
+            size_t stride;
+            hwy::AlignedFreeUniquePtr<float[]> storage;
+
+            /// Round up to whole vectors, so the CMND starts aligned as well.
+            static size_t paddedSize(const size_t size) {
+                const size_t alignment = HWY_ALIGNMENT / sizeof(float);
+                return (size + alignment - 1) / alignment * alignment;
+            }
+        };
+
+        /**
+         * Cumulative mean normalization, cmnd[tau] = d(tau) * tau / (runningSum + sum_{t=first}^{tau} d(t))
+         * for tau in [first, last].
+         */
+        void normalizeDifference(const float *diff, const unsigned int first, const unsigned int last,
+                                 float runningSum, float *cmnd) {
+            for (unsigned int tau = first; tau <= last; ++tau) {
                 runningSum += diff[tau];
                 cmnd[tau] = diff[tau] * static_cast<float>(tau) / runningSum;
             }
+        }
 
-            // Find the pitch for this window based on the cmnd function and threshold
-            unsigned int bestTau = 0;
-
-            // Search for first local minimum below threshold
+        /**
+         * First local minimum of the CMND below the threshold, searched in (tauMin, tauMax - 1).
+         * @return Its tau, 0 if there is none.
+         */
+        unsigned int firstDip(const float *cmnd, const unsigned int tauMin, const unsigned int tauMax,
+                              const float threshold) {
             for (unsigned int tau = tauMin + 1; tau < tauMax - 1; ++tau) {
                 if (cmnd[tau] < threshold &&
                     cmnd[tau] < cmnd[tau - 1] &&
                     cmnd[tau] <= cmnd[tau + 1]) {
-                    bestTau = tau;
-                    break;
-                }
-            }
-
-            // Fallback: global minimum in range if nothing passed threshold
-            if (bestTau == 0) {
-                bestTau = tauMin;
-                for (int tau = tauMin + 1; tau <= tauMax; ++tau) {
-                    if (cmnd[tau] < cmnd[bestTau]) {
-                        bestTau = tau;
-                    }
+                    return tau;
                 }
             }
+            return 0;
+        }
 
-            // Quadratic interpolation around best_tau (on CMND)
+        /**
+         * Quadratic interpolation of the CMND around bestTau, which stays put at the ends of [tauMin, tauMax].
+         */
+        float interpolateDip(const float *cmnd, const unsigned int bestTau, const unsigned int tauMin,
+                             const unsigned int tauMax) {
             auto refinedTau = static_cast<float>(bestTau);
 
             if (bestTau > tauMin && bestTau < tauMax) {
@@ -132,30 +400,274 @@ namespace p2t {
                     refinedTau += delta;
                 }
             }
-            pitchValues[i] = static_cast<float>(downsampledFs) / refinedTau;
+            return refinedTau;
         }
 
-        // smooth the pitch values by removing octave jumps down
-        for (size_t i = 1; i < pitchValues.size(); ++i) {
-            float octaveJumpThreshold = pitchValues[i - 1] / 1.5f;
-            // if the pitch drops by more than a perfect fifth, it's likely an octave jump
-            if (pitchValues[i] < octaveJumpThreshold) {
-                pitchValues[i] *= 2.0f; // assume it's an octave jump and correct it
+        /**
+         * YIN steps 3 to 5 on a difference function: cumulative mean normalization, the first local
+         * minimum below the threshold (the global minimum if there is none), parabolic interpolation.
+         * @param diff d(tau) for tau in [tauMin, tauMax].
+         * @param cmnd Scratch space for tauMax + 1 values.
+         * @param sumOffset Start of the running sum, which keeps near-silent windows from passing the threshold.
+         * @return Fractional period in samples.
+         */
+        float cmndPeriod(const float *diff, const unsigned int tauMin, const unsigned int tauMax,
+                         const float threshold, float *cmnd, const float sumOffset) {
+            // CMND (Cumulative Mean Normalized Difference Function)
+            normalizeDifference(diff, tauMin, tauMax, sumOffset, cmnd);
+
+            // Search for first local minimum below threshold
+            unsigned int bestTau = firstDip(cmnd, tauMin, tauMax, threshold);
+
+            // Fallback: global minimum in range if nothing passed threshold
+            if (bestTau == 0) {
+                bestTau = tauMin;
+                for (unsigned int tau = tauMin + 1; tau <= tauMax; ++tau) {
+                    if (cmnd[tau] < cmnd[bestTau]) {
+                        bestTau = tau;
+                    }
+                }
+            }
+
+            return interpolateDip(cmnd, bestTau, tauMin, tauMax);
+        }
+
+        /**
+         * YIN periods of equally sized windows of a signal.
+         * @param windowStart Maps a window index to the index of its first sample.
+         * @param stride Distance of consecutive windows, used by the Incremental method; windows that
+         *               do not follow at this distance are computed directly.
+         * @param sumOffset Start of the CMND running sum, 1 for windows of the detector's size and
+         *                  proportionally less for shorter ones.
+         * @return Fractional period in samples per window, 0 for silent windows.
+         */
+        template<typename WindowStart>
+        std::vector<float> windowPeriods(const std::vector<float> &signal, const int numWindows,
+                                         WindowStart windowStart, const int windowSize, const int stride,
+                                         const unsigned int tauMin, const unsigned int tauMax, const float threshold,
+                                         const DifferenceMethod differenceMethod, const float sumOffset) {
+            const std::vector<double> squares = prefixSquares(signal);
+            std::vector<float> periods(numWindows);
+#pragma omp parallel
+            {
+                // state of the Fft and Incremental methods, one per thread
+                std::unique_ptr<FftDifference> fftWorker;
+                std::unique_ptr<IncrementalDifference> incrementalWorker;
+                if (differenceMethod == DifferenceMethod::Fft) {
+                    fftWorker = std::make_unique<FftDifference>(windowSize, tauMax);
+                } else if (differenceMethod == DifferenceMethod::Incremental) {
+                    incrementalWorker = std::make_unique<IncrementalDifference>(stride, tauMax);
+                }
+                const DifferenceScratch scratch(tauMax);
+
+#pragma omp for schedule(dynamic, 16)
+                // prevent false sharing of periods by using dynamic scheduling with small chunks
+                for (int i = 0; i < numWindows; i++) {
+                    // Process each window
+                    const int start = windowStart(i);
+                    const int size = std::min(windowSize, static_cast<int>(signal.size()) - start);
+                    if (isSilent(squares.data() + start, size)) {
+                        periods[i] = 0.0f; // 0 Hz = unvoiced
+                        continue;
+                    }
+                    const float *window = signal.data() + start;
+
+                    float *diff = scratch.diff();
+                    if (fftWorker) {
+                        fftWorker->compute(window, squares.data() + start, size, tauMin, tauMax, diff);
+                    } else if (incrementalWorker) {
+                        // dynamic scheduling hands out runs of 16 consecutive windows, which the updates follow
+                        incrementalWorker->compute(window, start, size, tauMin, tauMax, diff);
+                    } else {
+                        directDifference(window, size, tauMin, tauMax, diff);
+                    }
+
+                    periods[i] = cmndPeriod(diff, tauMin, tauMax, threshold, scratch.cmnd(), sumOffset);
+                }
+            }
+            return periods;
+        }
+
+        /**
+         * windowPeriods for consecutive windows, each scanning only up to a little above the previous
+         * window's period first.
+         *
+         * The CMND is scanned from tauMin up to TRACKING_BAND_SEMITONES above the previous period,
+         * rounded up to whole DIFFERENCE_TAU_BLOCK tiles so the difference values equal those of the
+         * full Direct search. A dip below the threshold there is the first one of the full search, so
+         * lower periods such as octave jumps are found as well. Otherwise, after a silent window and at
+         * the start of a thread's contiguous chunk, the window searches [tauMin, tauMax] as windowPeriods
+         * does, with the Fft method or else Direct continuing from the scanned taus, as the Incremental
+         * sums cannot follow partially scanned windows.
+         */
+        std::vector<float> trackedWindowPeriods(const std::vector<float> &signal, const int numWindows,
+                                                const int windowSize, const int stride, const unsigned int tauMin,
+                                                const unsigned int tauMax, const float threshold,
+                                                const DifferenceMethod differenceMethod) {
+            const float bandRatio = std::exp2(TRACKING_BAND_SEMITONES / 12.0f);
+            const std::vector<double> squares = prefixSquares(signal);
+
+            std::vector<float> periods(numWindows);
+#pragma omp parallel
+            {
+                std::unique_ptr<FftDifference> fftWorker;
+                if (differenceMethod == DifferenceMethod::Fft) {
+                    fftWorker = std::make_unique<FftDifference>(windowSize, tauMax);
+                }
+                const DifferenceScratch scratch(tauMax);
+                float *diff = scratch.diff();
+                float *cmnd = scratch.cmnd();
+                int previousWindow = -2;
+                float previousPeriod = 0.0f;
+
+#pragma omp for schedule(static)
+                // every thread tracks through one contiguous chunk of windows
+                for (int i = 0; i < numWindows; i++) {
+                    const size_t start = static_cast<size_t>(i) * stride;
+                    const float *window = signal.data() + start;
+                    const int size = std::min(windowSize, static_cast<int>(signal.size() - start));
+                    if (isSilent(squares.data() + start, size)) {
+                        periods[i] = 0.0f;
+                        previousWindow = i;
+                        previousPeriod = 0.0f;
+                        continue;
+                    }
+
+                    float period = 0.0f;
+                    unsigned int scanned = tauMin; // taus below this already hold direct differences
+                    if (previousWindow == i - 1 && previousPeriod > 0.0f) {
+                        const auto bandEnd = static_cast<unsigned int>(std::ceil(previousPeriod * bandRatio));
+                        const unsigned int blocks = (bandEnd - std::min(bandEnd, tauMin)) / DIFFERENCE_TAU_BLOCK + 1;
+                        const unsigned int high = std::min(tauMax, tauMin + blocks * DIFFERENCE_TAU_BLOCK - 1);
+                        if (high < tauMax) {
+                            directDifference(window, size, tauMin, high, diff);
+                            normalizeDifference(diff, tauMin, high, 1.0f, cmnd);
+                            if (const unsigned int bestTau = firstDip(cmnd, tauMin, high, threshold)) {
+                                period = interpolateDip(cmnd, bestTau, tauMin, high);
+                            }
+                            scanned = high + 1;
+                        }
+                    }
+
+                    if (period == 0.0f) {
+                        if (fftWorker) {
+                            fftWorker->compute(window, squares.data() + start, size, tauMin, tauMax, diff);
+                        } else {
+                            directDifference(window, size, scanned, tauMax, diff);
+                        }
+                        period = cmndPeriod(diff, tauMin, tauMax, threshold, cmnd, 1.0f);
+                    }
+
+                    periods[i] = period;
+                    previousWindow = i;
+                    previousPeriod = period;
+                }
+            }
+            return periods;
+        }
+
+        /**
+         * Minimum of the difference function within radius of a candidate period, refined by parabolic
+         * interpolation of d(tau) as in the YIN paper.
+         * @param diff Scratch space for tauMax + 2 values.
+         * @return Fractional period in samples.
+         */
+        float refinePeriod(const float *samples, const int size, const float center, const int radius,
+                           const unsigned int tauMin, const unsigned int tauMax, float *diff) {
+            const int low = std::max(static_cast<int>(std::floor(center)) - radius, static_cast<int>(tauMin));
+            const int high = std::min(static_cast<int>(std::ceil(center)) + radius, static_cast<int>(tauMax));
+            if (low > high) return center;
+            // one more tau on either side for the interpolation
+            const int first = std::max(low - 1, 1);
+            const int last = std::min(high + 1, size - 1);
+            directDifference(samples, size, first, last, diff);
+
+            int bestTau = low;
+            for (int tau = low + 1; tau <= high; ++tau) {
+                if (diff[tau] < diff[bestTau]) bestTau = tau;
+            }
+
+            auto refinedTau = static_cast<float>(bestTau);
+            if (bestTau > first && bestTau < last) {
+                const float left = diff[bestTau - 1];
+                const float middle = diff[bestTau];
+                const float right = diff[bestTau + 1];
+                // only a local minimum keeps the vertex within half a sample
+                if (middle > left || middle > right) return refinedTau;
+
+                const float denom = 2.0f * (left - 2.0f * middle + right);
+                if (std::abs(denom) > 1e-12f) {
+                    refinedTau += (left - right) / denom;
+                }
             }
+            return refinedTau;
         }
-        // smooth by median filter with window size 5
-        std::vector<float> smoothedPitches = pitchValues;
-        const int medianWindow = 5;
-        for (int i = 0; i < pitchValues.size(); ++i) {
-            std::vector<float> window;
-            for (int j = -medianWindow / 2; j <= medianWindow / 2; ++j) {
-                if (j + i >= 0 && i + j < pitchValues.size()) {
-                    window.push_back(pitchValues[i + j]);
+
+        /**
+         * Remove octave jumps down and median filter the pitch track in place.
+         */
+        void smoothPitches(std::vector<float> &pitchValues) {
+            // smooth the pitch values by removing octave jumps down
+            for (size_t i = 1; i < pitchValues.size(); ++i) {
+                float octaveJumpThreshold = pitchValues[i - 1] / 1.5f;
+                // if the pitch drops by more than a perfect fifth, it's likely an octave jump
+                if (pitchValues[i] < octaveJumpThreshold) {
+                    pitchValues[i] *= 2.0f; // assume it's an octave jump and correct it
+                }
+            }
+            // smooth by median filter with window size 5
+            std::vector<float> smoothedPitches = pitchValues;
+            constexpr int medianWindow = 5;
+            const int count = static_cast<int>(pitchValues.size());
+            for (int i = 0; i < count; ++i) {
+                const int first = std::max(i - medianWindow / 2, 0);
+                const int last = std::min(i + medianWindow / 2, count - 1);
+                const size_t size = std::min<size_t>(last - first + 1, medianWindow);
+                // Insertion sort of at most medianWindow values, which std::sort's generic paths cannot bound
+                std::array<float, medianWindow> window{};
+                for (size_t k = 0; k < size; ++k) {
+                    size_t m = k;
+                    for (; m > 0 && window[m - 1] > pitchValues[first + k]; --m) window[m] = window[m - 1];
+                    window[m] = pitchValues[first + k];
                 }
+                smoothedPitches[i] = window[size / 2]; // median
             }
-            std::sort(window.begin(), window.end());
-            smoothedPitches[i] = window[window.size() / 2]; // median
+            pitchValues = std::move(smoothedPitches);
         }
+    }
+
+    WindowedData<float> YINPitchDetector::detectPitch(const WavData &audioBuffer, const PitchRange pitchRange,
+                                                      const float threshold, const int decimationFactor,
+                                                      const DifferenceMethod method, const SearchMode mode) const {
+        if (mode == SearchMode::CoarseToFine && decimationFactor > 1) {
+            return detectPitchCoarseToFine(audioBuffer, pitchRange, threshold, decimationFactor, method);
+        }
+
+        std::vector<float> downsampledAudio =
+                decimate(audioBuffer.samples, decimationFactor);
+
+        const unsigned int downsampledFs =
+                audioBuffer.sampleRate / decimationFactor;
+
+        const unsigned int tauMin = downsampledFs / static_cast<int>(pitchRange.max);
+        const unsigned int tauMax = downsampledFs / static_cast<int>(pitchRange.min);
+        const DifferenceMethod differenceMethod = resolveDifferenceMethod(method, this->windowing, tauMin, tauMax);
+
+        const unsigned int numWindows = (downsampledAudio.size() - this->windowing.windowSize) / this->windowing.
+                                        stride + 1;
+        const int stride = this->windowing.stride;
+        std::vector<float> pitchValues =
+                mode == SearchMode::Tracking
+                    ? trackedWindowPeriods(downsampledAudio, static_cast<int>(numWindows), this->windowing.windowSize,
+                                           stride, tauMin, tauMax, threshold, differenceMethod)
+                    : windowPeriods(downsampledAudio, static_cast<int>(numWindows),
+                                    [stride](const int i) { return i * stride; }, this->windowing.windowSize, stride,
+                                    tauMin, tauMax, threshold, differenceMethod, 1.0f);
+        for (float &pitch: pitchValues) {
+            if (pitch > 0.0f) pitch = static_cast<float>(downsampledFs) / pitch;
+        }
+
+        smoothPitches(pitchValues);
 
         // Get original windowing
         const unsigned int uncompressedNumWindows = audioBuffer.samples.size() / this->windowing.stride;
@@ -163,12 +675,12 @@ namespace p2t {
 
         for (int i = 0; i < uncompressedNumWindows; ++i) {
             int j = i / decimationFactor;
-            if (j >= smoothedPitches.size() - 1) {
-                uncompressedPitchValues[i] = smoothedPitches[smoothedPitches.size() - 1];
+            if (j >= pitchValues.size() - 1) {
+                uncompressedPitchValues[i] = pitchValues[pitchValues.size() - 1];
             } else {
                 // Linear Interpolation
-                const float start = smoothedPitches[j];
-                const float end = start == 0 ? 0 : (smoothedPitches[j + 1] == 0 ? start : smoothedPitches[j + 1]);
+                const float start = pitchValues[j];
+                const float end = start == 0 ? 0 : (pitchValues[j + 1] == 0 ? start : pitchValues[j + 1]);
                 const float frac = static_cast<float>(i % decimationFactor) / decimationFactor;
                 uncompressedPitchValues[i] = (1 - frac) * start + frac * end;
             }
@@ -179,6 +691,70 @@ namespace p2t {
         };
     }
 
+
+    WindowedData<float> YINPitchDetector::detectPitchCoarseToFine(const WavData &audioBuffer,
+                                                                  const PitchRange pitchRange, const float threshold,
+                                                                  const int decimationFactor,
+                                                                  const DifferenceMethod method) const {
+        const std::vector<float> &samples = audioBuffer.samples;
+        const int windowSize = this->windowing.windowSize;
+        const int stride = this->windowing.stride;
+        const std::vector<float> downsampledAudio = decimate(samples, decimationFactor);
+
+        // Coarse pass: the same windows at the decimated rate, window i starting at i * stride / decimationFactor
+        const unsigned int downsampledFs = audioBuffer.sampleRate / decimationFactor;
+        const unsigned int coarseTauMin = downsampledFs / static_cast<int>(pitchRange.max);
+        const unsigned int coarseTauMax = downsampledFs / static_cast<int>(pitchRange.min);
+        const Windowing coarseWindowing(windowSize / decimationFactor, std::max(stride / decimationFactor, 1));
+        const DifferenceMethod coarseMethod = resolveDifferenceMethod(method, coarseWindowing, coarseTauMin,
+                                                                      coarseTauMax);
+
+        const int numWindows = samples.size() < static_cast<size_t>(windowSize)
+                                   ? 0
+                                   : static_cast<int>((samples.size() - windowSize) / stride) + 1;
+        const std::vector<float> coarsePeriods = windowPeriods(
+            downsampledAudio, numWindows,
+            [stride, decimationFactor](const int i) {
+                return static_cast<int>(static_cast<long>(i) * stride / decimationFactor);
+            },
+            coarseWindowing.windowSize, coarseWindowing.stride, coarseTauMin, coarseTauMax, threshold, coarseMethod,
+            1.0f / static_cast<float>(decimationFactor));
+
+        // Fine pass: the full-rate difference function only within one coarse tau either side of the coarse estimate
+        const unsigned int tauMin = audioBuffer.sampleRate / static_cast<int>(pitchRange.max);
+        const unsigned int tauMax = audioBuffer.sampleRate / static_cast<int>(pitchRange.min);
+        std::vector<float> pitchValues(numWindows);
+#pragma omp parallel
+        {
+            const DifferenceScratch scratch(tauMax);
+
+#pragma omp for schedule(dynamic, 16)
+            for (int i = 0; i < numWindows; ++i) {
+                if (coarsePeriods[i] <= 0.0f) {
+                    pitchValues[i] = 0.0f;
+                    continue;
+                }
+
+                const float *window = samples.data() + static_cast<size_t>(i) * stride;
+                const float center = coarsePeriods[i] * static_cast<float>(decimationFactor);
+                const float refinedTau = refinePeriod(window, windowSize, center, decimationFactor, tauMin, tauMax,
+                                                      scratch.diff());
+                pitchValues[i] = static_cast<float>(audioBuffer.sampleRate) / refinedTau;
+            }
+        }
+
+        smoothPitches(pitchValues);
+
+        // Same number of windows as the Decimated mode, the last estimate repeated up to the end
+        const unsigned int uncompressedNumWindows = samples.size() / stride;
+        const float lastPitch = pitchValues.empty() ? 0.0f : pitchValues.back();
+        pitchValues.resize(uncompressedNumWindows, lastPitch);
+
+        return {
+            this->windowing, pitchValues
+        };
+    }
+
     YINPitchDetector::YINPitchDetector(const Windowing windowing) : windowing(windowing) {
     }
 
@@ -210,101 +786,129 @@ namespace p2t {
         return h;
     }
 
-    // Convolution (valid for FIR filtering)
-    std::vector<float> YINPitchDetector::convolve(
-        const std::vector<float> &signal,
-        const std::vector<float> &kernel) {
-        const int signalSize = static_cast<int>(signal.size());
-        const int kernelSize = static_cast<int>(kernel.size());
-        std::vector<float> output(signalSize, 0.0f);
-
-        // Pre-reverse kernel so the inner loop accesses both arrays forward:
-        // output[n] = sum_k kernel[k]*signal[n-k]
-        //           = sum_j kernelRev[j]*signal[n-(kernelSize-1)+j]
-        const std::vector<float> kernelRev(kernel.rbegin(), kernel.rend());
-
-#pragma omp parallel for schedule(dynamic, 16)
-        for (int n = 0; n < signalSize; ++n) {
-            // For n < kernelSize-1, only a partial prefix of the kernel contributes.
-            const int kStart = std::max(0, n - kernelSize + 1);
-            const int len = n - kStart + 1;
-            const int kRevOffset = kernelSize - 1 - n + kStart;
-
-            const float *sigPtr = signal.data() + kStart;
-            const float *kerPtr = kernelRev.data() + kRevOffset;
-
-            float acc = 0.0f;
-            int k = 0;
-# if USE_HWY
-            ScalableTag<float> d;
-            const int lanes = static_cast<int>(Lanes(d));
-            auto vecAcc = Zero(d);
+    // Half-band lowpass: cutoff at a quarter of the rate, every second tap off the center exactly zero.
+    // Kaiser-windowed for sidelobes below DECIMATION_STOPBAND_DB; the length sets the transition width.
+    std::vector<float> YINPitchDetector::designHalfbandFir(const int taps) {
+        const double attenuation = DECIMATION_STOPBAND_DB + KAISER_MARGIN_DB;
+        const double beta = 0.1102 * (attenuation - 8.7);
+        const int center = (taps - 1) / 2;
 
-            for (; k + lanes <= len; k += lanes) {
-                const auto vs = Load(d, sigPtr + k);
-                const auto vk = Load(d, kerPtr + k);
-                vecAcc = MulAdd(vk, vs, vecAcc);
-            }
-            // Formally: acc = ReduceSum(d, vecAcc); But doesnt seam to exist in our hwy build
-            acc = GetLane(SumOfLanes(d, vecAcc));
-# endif
-            // Scalar remainder (and full scalar path when USE_HWY=0)
-            for (; k < len; ++k)
-                acc += sigPtr[k] * kerPtr[k];
-
-            output[n] = acc;
+        std::vector<float> h(taps);
+        double sum = 0.0;
+        for (int n = 0; n < taps; ++n) {
+            const int offset = n - center;
+            if (offset != 0 && offset % 2 == 0) continue;
+
+            const double ratio = static_cast<double>(offset) / center;
+            const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+            const double ideal = offset == 0 ? 0.5 : std::sin(M_PI * offset / 2.0) / (M_PI * offset);
+            h[n] = static_cast<float>(ideal * window);
+            sum += h[n];
         }
 
-        return output;
+        // Normalize for unity DC gain
+        for (float &v: h) v = static_cast<float>(v / sum);
+        return h;
     }
 
-    // Zero-phase decimation
-    std::vector<float> YINPitchDetector::decimateZeroPhase(const std::vector<float> &input, const int factor) {
-        if (factor <= 1)
-            return input;
-
-        if (input.empty())
-            return {};
-
+    // Zero-phase lowpass of decimateZeroPhase, the 101-tap design applied forward and backward
+    std::vector<float> YINPitchDetector::designZeroPhaseFir(const int factor) {
         // FIR parameters
         constexpr int taps = 101; // increase for sharper cutoff
         const float cutoff = 0.5f / static_cast<float>(factor); // normalized cutoff
 
-        auto fir = designLowpassFir(taps, cutoff);
-
-        // Forward filter
-        auto forward = convolve(input, fir);
+        const auto fir = designLowpassFir(taps, cutoff);
 
-        // Reverse
-        std::vector<float> reversed(forward.rbegin(), forward.rend());
-
-        // Backward filter
-        auto backward = convolve(reversed, fir);
+        // Filtering forward and backward with fir equals one pass with fir convolved with itself
+        // reversed; fir is symmetric, so that is fir * fir. The product is symmetric again, i.e.
+        // linear phase, and advancing it by its group delay makes it zero phase in a single pass.
+        std::vector<float> symmetric(2 * taps - 1, 0.0f);
+        for (int i = 0; i < taps; ++i) {
+            for (int j = 0; j < taps; ++j) symmetric[i + j] += fir[i] * fir[j];
+        }
+        return symmetric;
+    }
 
-        // Reverse again → zero phase
-        std::vector<float> filtered(backward.rbegin(), backward.rend());
+    // Zero-phase decimation
+    std::vector<float> YINPitchDetector::decimateZeroPhase(const std::vector<float> &input, const int factor) {
+        auto fir = designZeroPhaseFir(factor);
+        const int delay = static_cast<int>(fir.size() - 1) / 2;
+        return FirFilter(std::move(fir), factor).apply(input, delay);
+    }
 
-        // Downsample using HWY-aligned memory
-        const size_t outputSize = filtered.size() / factor;
+    // Multistage decimation by half-band stages, each as short as the passband of decimateZeroPhase allows
+    std::vector<float> YINPitchDetector::decimateHalfbandCascade(const std::vector<float> &input, const int factor) {
+        // Designing the stages scans frequency responses, so every factor is designed once
+        static std::mutex designMutex;
+        static std::map<int, std::vector<FirFilter> > designs;
+        std::vector<FirFilter> *stages;
+        {
+            std::lock_guard lock(designMutex);
+            auto it = designs.find(factor);
+            if (it == designs.end()) {
+                it = designs.emplace(factor, designHalfbandCascade(factor)).first;
+            }
+            stages = &it->second;
+        }
 
-        // Allocate HWY-aligned memory (aligned to vector width for optimal SIMD access)
-        float * HWY_RESTRICT alignedOutput = static_cast<float *>(
-            hwy::AllocateAlignedBytes(outputSize * sizeof(float), nullptr, nullptr));
+        if (stages->empty()) {
+            return decimateZeroPhase(input, factor);
+        }
 
-        if (!alignedOutput) {
-            throw std::runtime_error("Failed to allocate aligned memory for decimation");
+        std::vector<float> signal = stages->front().apply(input, stages->front().taps() / 2);
+        for (size_t stage = 1; stage < stages->size(); ++stage) {
+            signal = (*stages)[stage].apply(signal, (*stages)[stage].taps() / 2);
         }
+        return signal;
+    }
 
-        // Downsample into aligned buffer
-        size_t outIdx = 0;
-        for (size_t i = 0; i < filtered.size(); i += factor) {
-            alignedOutput[outIdx++] = filtered[i];
+    // Half-band stages, each as short as the passband of decimateZeroPhase and DECIMATION_STOPBAND_DB
+    // allow, or none if a stage would need more than HALFBAND_MAX_TAPS
+    std::vector<FirFilter> YINPitchDetector::designHalfbandCascade(const int factor) {
+        int stageCount = 0;
+        while ((1 << stageCount) < factor) ++stageCount;
+
+        // Passband edge of the single-stage design, in cycles per input sample
+        const float edge = passbandEdge(designZeroPhaseFir(factor), DECIMATION_PASSBAND_TOLERANCE_DB);
+        const float stageTolerance = DECIMATION_PASSBAND_TOLERANCE_DB / static_cast<float>(stageCount);
+
+        std::vector<FirFilter> stages;
+        for (int stage = 0; stage < stageCount; ++stage) {
+            // The edge relative to the rate of this stage grows as the rate halves. Halving the rate folds
+            // [0.5 - stageEdge, 0.5] onto the passband, so that is where the stage must reject.
+            const float stageEdge = edge * static_cast<float>(1 << stage);
+            std::vector<float> fir;
+            for (int taps = HALFBAND_MIN_TAPS; taps <= HALFBAND_MAX_TAPS && fir.empty(); taps += 4) {
+                auto candidate = designHalfbandFir(taps);
+                if (withinTolerance(candidate, stageEdge, stageTolerance) &&
+                    withinStopband(candidate, 0.5f - stageEdge, DECIMATION_STOPBAND_DB)) {
+                    fir = std::move(candidate);
+                }
+            }
+            if (fir.empty()) {
+                return {};
+            }
+            stages.emplace_back(std::move(fir), 2);
         }
+        return stages;
+    }
+
+    std::vector<float> YINPitchDetector::decimate(const std::vector<float> &input, const int factor,
+                                                  const DecimationMethod method) {
+        if (factor <= 1)
+            return input;
 
-        // Copy to std::vector and free aligned memory
-        std::vector<float> output(alignedOutput, alignedOutput + outputSize);
-        hwy::FreeAlignedBytes(alignedOutput, nullptr, nullptr);
+        if (input.empty())
+            return {};
 
-        return output;
+        const bool powerOfTwo = (factor & (factor - 1)) == 0;
+        if (method == DecimationMethod::HalfbandCascade && !powerOfTwo) {
+            throw std::invalid_argument("Half-band cascade needs a power-of-two factor but got: " +
+                                        std::to_string(factor));
+        }
+        if (method == DecimationMethod::ZeroPhase || !powerOfTwo) {
+            return decimateZeroPhase(input, factor);
+        }
+        return decimateHalfbandCascade(input, factor);
     }
 }
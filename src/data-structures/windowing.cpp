@@ -1,5 +1,8 @@
 #include "pytotune/data-structures/windowing.h"
 
+#include <stdexcept>
+#include <string>
+
 namespace p2t {
     Windowing::Windowing(int windowSize, int stride)
         : windowSize(windowSize),
@@ -10,4 +13,18 @@ namespace p2t {
         : windowSize(windowSize),
           stride(windowSize - static_cast<int>(overlapPercentage * static_cast<float>(windowSize))) {
     }
+
+    void Windowing::validateForFft() const {
+        if (windowSize < 2 || windowSize % 2 != 0) {
+            throw std::invalid_argument("Window size must be even and at least 2 but got: " + std::to_string(windowSize));
+        }
+        if (stride < 1 || stride > windowSize) {
+            throw std::invalid_argument(
+                "Stride must be between 1 and the window size but got: " + std::to_string(stride));
+        }
+        if (windowSize % stride != 0) {
+            throw std::invalid_argument("Stride must divide the window size but got: " + std::to_string(stride) +
+                                        " for window size " + std::to_string(windowSize));
+        }
+    }
 }
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "pytotune/api.h"
+#include "pytotune/algorithms/fft_planner.h"
 #include "pytotune/data-structures/scale.h"
 
 namespace py = pybind11;
@@ -115,4 +116,8 @@ PYBIND11_MODULE(pytotune, m) {
         m.def("roundToScale", &p2t::roundToScale, "Tune a WAV file to a musical scale",
           py::arg("wav_path"), py::arg("scale"), py::arg("out_path"),
           py::arg("pitch_range") = p2t::VoiceRanges::HUMAN);
+
+        m.def("tuneFft", &p2t::tuneFft,
+          "Measure the fastest FFT kernels of this CPU and store them in the wisdom file",
+          py::arg("sizes") = std::vector<int>{64, 128, 256, 512, 1024, 2048, 4096, 8192});
 }
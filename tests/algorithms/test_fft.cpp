@@ -1,11 +1,36 @@
 #include <cmath>
 #include <gtest/gtest.h>
+#include <omp.h>
 #include <vector>
 #include "pytotune/algorithms/fft.h"
+#include "pytotune/algorithms/fixed_size_fft.h"
 #include "../test_utils.h"
 
+// Runs every smbFft test once per kernel
+class SmbFftTest : public ::testing::TestWithParam<p2t::FftKernel> {
+protected:
+    void SetUp() override {
+        previousKernel = p2t::getSmbFftKernel();
+        p2t::setSmbFftKernel(GetParam());
+    }
+
+    void TearDown() override {
+        p2t::setSmbFftKernel(previousKernel);
+    }
+
+private:
+    p2t::FftKernel previousKernel = p2t::DEFAULT_FFT_KERNEL;
+};
+
+INSTANTIATE_TEST_SUITE_P(Kernels, SmbFftTest,
+                         ::testing::Values(p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::Radix4,
+                                           p2t::FftKernel::Stockham, p2t::FftKernel::FixedSize,
+                                           p2t::FftKernel::FourStep),
+                         [](const ::testing::TestParamInfo<p2t::FftKernel> &info) {
+                         return std::string(p2t::fftKernelName(info.param));
+                         });
 
-TEST(SmbFftTest, NoOpForZeros) {
+TEST_P(SmbFftTest, NoOpForZeros) {
     int n = 4;
     std::vector<float> buf(2 * n, 0.0f);
 
@@ -15,7 +40,7 @@ TEST(SmbFftTest, NoOpForZeros) {
     EXPECT_NEAR_VEC(buf, std::vector<float>(2 * n));
 }
 
-TEST(SmbFftTest, ImpulseProducesFlatSpectrum) {
+TEST_P(SmbFftTest, ImpulseProducesFlatSpectrum) {
     long N = 4;
     std::vector<float> buf(2 * N, 0.0f);
 
@@ -35,7 +60,7 @@ TEST(SmbFftTest, ImpulseProducesFlatSpectrum) {
     EXPECT_NEAR_VEC(buf, expected);
 }
 
-TEST(SmbFftTest, SimpleKnownTransformSize4) {
+TEST_P(SmbFftTest, SimpleKnownTransformSize4) {
     long N = 4;
 
     // Input: real sequence [1, 2, 3, 4], imag = 0
@@ -56,7 +81,7 @@ TEST(SmbFftTest, SimpleKnownTransformSize4) {
     EXPECT_NEAR_VEC(buf, expected);
 }
 
-TEST(SmbFftTest, InverseReturnsOriginalForSize4) {
+TEST_P(SmbFftTest, InverseReturnsOriginalForSize4) {
     long N = 4;
     std::vector<float> original = {1, 0, 2, 0, 3, 0, 4, 0};
     std::vector<float> buf = original;
@@ -71,7 +96,7 @@ TEST(SmbFftTest, InverseReturnsOriginalForSize4) {
     EXPECT_NEAR_VEC(buf, original);
 }
 
-TEST(SmbFftTest, HandlesNonTrivialImagParts) {
+TEST_P(SmbFftTest, HandlesNonTrivialImagParts) {
     long N = 4;
     std::vector<float> buf = {
         1, 1, // 1 + i
@@ -92,7 +117,7 @@ TEST(SmbFftTest, HandlesNonTrivialImagParts) {
 }
 
 // Test A: Real sine -> two symmetric bins (k and N-k)
-TEST(SmbFftTest, RealSine_TwoSymmetricBins) {
+TEST_P(SmbFftTest, RealSine_TwoSymmetricBins) {
     const int N = 1024;
     const float fs = 48000.0f;
     const int k = 10; // target bin
@@ -128,7 +153,7 @@ TEST(SmbFftTest, RealSine_TwoSymmetricBins) {
 }
 
 // Test B: Complex exponential -> single bin k non-zero
-TEST(SmbFftTest, ComplexExponential_SingleBin) {
+TEST_P(SmbFftTest, ComplexExponential_SingleBin) {
     const int N = 1024;
     const float fs = 48000.0f;
     const int k = 10;
@@ -165,3 +190,323 @@ TEST(SmbFftTest, ComplexExponential_SingleBin) {
 
 
 
+
+// Naive O(N^2) DFT in double precision used as ground truth
+static std::vector<float> naiveDft(const std::vector<float> &buf, int N, int sign) {
+    std::vector<float> out(2 * N, 0.0f);
+    for (int k = 0; k < N; ++k) {
+        double re = 0.0, im = 0.0;
+        for (int n = 0; n < N; ++n) {
+            const double angle = sign * 2.0 * M_PI * static_cast<double>(k) * n / N;
+            re += buf[2 * n] * std::cos(angle) - buf[2 * n + 1] * std::sin(angle);
+            im += buf[2 * n] * std::sin(angle) + buf[2 * n + 1] * std::cos(angle);
+        }
+        out[2 * k] = static_cast<float>(re);
+        out[2 * k + 1] = static_cast<float>(im);
+    }
+    return out;
+}
+
+// Every kernel is checked against the same ground truth
+static const p2t::FftKernel ALL_KERNELS[] = {
+    p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::Radix4, p2t::FftKernel::Stockham,
+    p2t::FftKernel::FixedSize, p2t::FftKernel::FourStep
+};
+
+TEST(FftPlanTest, MatchesNaiveDft) {
+    for (const auto kernel: ALL_KERNELS) {
+        for (const int N: {1, 2, 4, 8, 32, 64, 512}) {
+            for (const int sign: {-1, 1}) {
+                std::vector<float> buf(2 * N);
+                for (int i = 0; i < 2 * N; ++i) buf[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+                const auto expected = naiveDft(buf, N, sign);
+
+                SCOPED_TRACE(std::string(p2t::fftKernelName(kernel)) + " N=" + std::to_string(N));
+                const p2t::FftPlan plan(N, kernel);
+                plan.execute(buf.data(), sign);
+
+                EXPECT_EQ(plan.size(), N);
+                EXPECT_NEAR_VEC_EPS(buf, expected, 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(FftPlanTest, FixedSizeMatchesRuntimePlan) {
+    for (int N = p2t::MIN_FIXED_FFT_SIZE; N <= p2t::MAX_FIXED_FFT_SIZE; N <<= 1) {
+        for (const int sign: {-1, 1}) {
+            std::vector<float> a(2 * N);
+            for (int i = 0; i < 2 * N; ++i) a[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+            std::vector<float> b = a;
+
+            SCOPED_TRACE("N=" + std::to_string(N));
+            ASSERT_TRUE(p2t::fixedSizeFft(a.data(), N, sign));
+            p2t::FftPlan(N, p2t::FftKernel::Radix2).execute(b.data(), sign);
+
+            EXPECT_NEAR_VEC_EPS(a, b, 1e-5f * N);
+        }
+    }
+
+    std::vector<float> untouched(2 * 96, 1.0f);
+    EXPECT_FALSE(p2t::fixedSizeFft(untouched.data(), 96, -1));
+    EXPECT_EQ(untouched, std::vector<float>(2 * 96, 1.0f));
+    EXPECT_EQ(p2t::FftPlan(4096, p2t::FftKernel::FixedSize).kernel(), p2t::FftKernel::FixedSize);
+    EXPECT_EQ(p2t::FftPlan(16, p2t::FftKernel::FixedSize).kernel(), p2t::DEFAULT_FFT_KERNEL);
+}
+
+TEST(FftPlanTest, FourStepMatchesRadix2ForLargeSizes) {
+    // Odd and even numbers of stages give square and non-square splits
+    for (const int N: {1 << 15, 1 << 16}) {
+        std::vector<float> a(2 * N);
+        for (int i = 0; i < 2 * N; ++i) a[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+        std::vector<float> b = a;
+
+        SCOPED_TRACE("N=" + std::to_string(N));
+        p2t::FftPlan(N, p2t::FftKernel::FourStep).execute(a.data(), -1);
+        p2t::FftPlan(N, p2t::FftKernel::Radix2).execute(b.data(), -1);
+
+        EXPECT_NEAR_VEC_EPS(a, b, 1e-1f);
+    }
+}
+
+TEST(FftPlanTest, ParallelMatchesSerial) {
+    const int previousThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+
+    for (const auto kernel: {p2t::FftKernel::Radix2, p2t::FftKernel::FourStep, p2t::FftKernel::Simd}) {
+        for (const int N: {8, 1 << 12, 1 << 17}) {
+            std::vector<float> a(2 * N);
+            for (int i = 0; i < 2 * N; ++i) a[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+            std::vector<float> b = a;
+
+            const p2t::FftPlan parallelPlan(N, kernel, true);
+            SCOPED_TRACE(std::string(p2t::fftKernelName(parallelPlan.kernel())) + " N=" + std::to_string(N));
+            EXPECT_TRUE(parallelPlan.isParallel());
+            parallelPlan.execute(a.data(), 1);
+            p2t::FftPlan(N, p2t::FftKernel::Radix2).execute(b.data(), 1);
+
+            EXPECT_NEAR_VEC_EPS(a, b, 1e-1f);
+        }
+    }
+
+    EXPECT_EQ(p2t::FftPlan(1024, p2t::FftKernel::Stockham, true).kernel(), p2t::FftKernel::FourStep);
+    EXPECT_FALSE(p2t::FftPlan(1000, p2t::FftKernel::Radix2, true).isParallel());
+    omp_set_num_threads(previousThreads);
+}
+
+TEST(FftPlanTest, ReusedPlanMatchesSmbFft) {
+    const int N = 256;
+    const p2t::FftPlan plan(N);
+    for (int sign: {-1, 1}) {
+        std::vector<float> a(2 * N);
+        for (int i = 0; i < 2 * N; ++i) a[i] = std::cos(0.11f * i * sign);
+        std::vector<float> b = a;
+
+        plan.execute(a.data(), sign);
+        p2t::smbFft(b, N, sign);
+
+        EXPECT_NEAR_VEC(a, b);
+    }
+}
+
+TEST(FftPlanTest, ArbitrarySizesMatchNaiveDft) {
+    // Only small primes go to MixedRadix, anything else to Bluestein
+    for (const int N: {3, 5, 6, 7, 12, 15, 60, 1920, 11, 13, 22, 97, 1000 + 9}) {
+        for (const int sign: {-1, 1}) {
+            std::vector<float> buf(2 * N);
+            for (int i = 0; i < 2 * N; ++i) buf[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+            const auto expected = naiveDft(buf, N, sign);
+
+            const p2t::FftPlan plan(N);
+            SCOPED_TRACE(std::string(p2t::fftKernelName(plan.kernel())) + " N=" + std::to_string(N));
+            plan.execute(buf.data(), sign);
+
+            EXPECT_NE(plan.kernel(), p2t::DEFAULT_FFT_KERNEL);
+            EXPECT_NEAR_VEC_EPS(buf, expected, 2e-3f * std::sqrt(static_cast<float>(N)));
+        }
+    }
+}
+
+TEST(FftPlanTest, SelectsKernelForSize) {
+    EXPECT_EQ(p2t::FftPlan(64, p2t::FftKernel::Radix4).kernel(), p2t::FftKernel::Radix4);
+    EXPECT_EQ(p2t::FftPlan(2880, p2t::FftKernel::Radix4).kernel(), p2t::FftKernel::MixedRadix);
+    EXPECT_EQ(p2t::FftPlan(22).kernel(), p2t::FftKernel::Bluestein);
+    EXPECT_EQ(p2t::FftPlan(64, p2t::FftKernel::Bluestein).kernel(), p2t::FftKernel::Bluestein);
+    EXPECT_EQ(p2t::FftPlan(44, p2t::FftKernel::MixedRadix).kernel(), p2t::FftKernel::Bluestein);
+}
+
+TEST(FftPlanTest, PrunedMatchesFullTransform) {
+    // Radix2 and Simd plans run the split stages, FixedSize and FourStep plans the fixed-size ones
+    for (const auto kernel: {p2t::FftKernel::Radix2, p2t::FftKernel::Simd, p2t::FftKernel::FixedSize,
+                             p2t::FftKernel::FourStep}) {
+        for (const int N: {8, 1024, 1 << 13}) {
+            // {non-zero inputs, used outputs}: input pruning, output pruning, both, neither, rounding up
+            for (const auto &[inputs, outputs]: {std::pair{N / 2, N}, {N, N / 4}, {N / 4, N / 2}, {N, N}, {3, 5}}) {
+                for (const int sign: {-1, 1}) {
+                    std::vector<float> a(2 * N, 0.0f);
+                    for (int i = 0; i < 2 * inputs; ++i) a[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+                    std::vector<float> b = a;
+
+                    const p2t::FftPlan plan(N, kernel);
+                    SCOPED_TRACE(std::string(p2t::fftKernelName(kernel)) + " N=" + std::to_string(N) + " in=" +
+                                 std::to_string(inputs) + " out=" + std::to_string(outputs));
+                    plan.executePruned(a.data(), sign, inputs, outputs);
+                    plan.execute(b.data(), sign);
+
+                    a.resize(2 * outputs);
+                    b.resize(2 * outputs);
+                    EXPECT_NEAR_VEC_EPS(a, b, 1e-5f * N);
+                }
+            }
+        }
+    }
+}
+
+TEST(FftPlanTest, PrunedFallsBackForArbitrarySizes) {
+    const int N = 60;
+    std::vector<float> a(2 * N, 0.0f);
+    for (int i = 0; i < N; ++i) a[i] = std::cos(0.11f * i);
+    std::vector<float> b = a;
+
+    const p2t::FftPlan plan(N);
+    plan.executePruned(a.data(), -1, N / 2, N / 4);
+    plan.execute(b.data(), -1);
+
+    EXPECT_NEAR_VEC(a, b);
+    EXPECT_THROW(plan.executePruned(a.data(), -1, 0, N), std::invalid_argument);
+    EXPECT_THROW(plan.executePruned(a.data(), -1, N, -1), std::invalid_argument);
+}
+
+TEST(FftPlanTest, RejectsNonPositiveSizes) {
+    EXPECT_THROW(p2t::FftPlan(0), std::invalid_argument);
+    EXPECT_THROW(p2t::FftPlan(-8), std::invalid_argument);
+}
+
+TEST(RealFftPlanTest, ForwardMatchesComplexFft) {
+    for (const int N: {2, 4, 16, 1024}) {
+        std::vector<float> real(N + 2, 0.0f);
+        std::vector<float> complex(2 * N, 0.0f);
+        for (int i = 0; i < N; ++i) {
+            real[i] = std::sin(0.21f * i) + 0.5f * std::cos(0.05f * i * i);
+            complex[2 * i] = real[i];
+        }
+
+        const p2t::RealFftPlan plan(N);
+        plan.forward(real.data());
+        p2t::smbFft(complex, N, -1);
+
+        complex.resize(N + 2);
+        EXPECT_NEAR_VEC_EPS(real, complex, 1e-3f);
+    }
+}
+
+TEST(RealFftPlanTest, InverseRoundTrip) {
+    const int N = 512;
+    std::vector<float> original(N + 2, 0.0f);
+    for (int i = 0; i < N; ++i) original[i] = std::cos(0.3f * i) * std::exp(-0.001f * i);
+    std::vector<float> buf = original;
+
+    const p2t::RealFftPlan plan(N);
+    plan.forward(buf.data());
+    plan.inverse(buf.data());
+
+    // Like smbFft, the inverse is not scaled by 1/N
+    for (auto &v: buf) v /= N;
+    buf.resize(N);
+    original.resize(N);
+    EXPECT_NEAR_VEC_EPS(buf, original, 1e-5f);
+}
+
+TEST(RealFftPlanTest, NonPowerOfTwoRoundTrip) {
+    for (const int N: {24, 1920, 2 * 97}) {
+        std::vector<float> real(N + 2, 0.0f);
+        std::vector<float> complex(2 * N, 0.0f);
+        for (int i = 0; i < N; ++i) {
+            real[i] = std::sin(0.21f * i) + 0.5f * std::cos(0.05f * i);
+            complex[2 * i] = real[i];
+        }
+        const auto original = real;
+
+        SCOPED_TRACE("N=" + std::to_string(N));
+        const p2t::RealFftPlan plan(N);
+        plan.forward(real.data());
+        p2t::smbFft(complex, N, -1);
+        complex.resize(N + 2);
+        EXPECT_NEAR_VEC_EPS(real, complex, 1e-4f * N);
+
+        plan.inverse(real.data());
+        for (int i = 0; i < N; ++i) {
+            EXPECT_NEAR(real[i] / N, original[i], 1e-4f);
+        }
+    }
+}
+
+TEST(RealFftPlanTest, PrunedMatchesFullTransform) {
+    const int N = 2048;
+    const p2t::RealFftPlan plan(N);
+    std::vector<float> a(N + 2, 0.0f);
+    for (int i = 0; i < 700; ++i) a[i] = std::sin(0.37f * i) + 0.25f * std::cos(1.3f * i);
+    std::vector<float> b = a;
+
+    plan.forwardPruned(a.data(), 700);
+    plan.forward(b.data());
+    EXPECT_NEAR_VEC_EPS(a, b, 1e-3f);
+
+    plan.inversePruned(a.data(), 301);
+    plan.inverse(b.data());
+    a.resize(301);
+    b.resize(301);
+    EXPECT_NEAR_VEC_EPS(a, b, 1e-1f);
+}
+
+TEST(RealFftPlanTest, RejectsUnsupportedSizes) {
+    EXPECT_THROW(p2t::RealFftPlan(0), std::invalid_argument);
+    EXPECT_THROW(p2t::RealFftPlan(1), std::invalid_argument);
+    EXPECT_THROW(p2t::RealFftPlan(25), std::invalid_argument);
+}
+
+TEST(FftBatchTest, MatchesSingleFrameTransforms) {
+    for (const int N: {2, 8, 256, 15, 11}) {
+        // Enough frames for full SIMD groups plus a remainder
+        for (const int count: {1, 3, 19}) {
+            std::vector<std::vector<float> > frames(count, std::vector<float>(2 * N));
+            for (int f = 0; f < count; ++f)
+                for (int i = 0; i < 2 * N; ++i) frames[f][i] = std::sin(0.1f * i + f) + 0.01f * f;
+            auto expected = frames;
+
+            p2t::fftBatch(frames.data(), count, N, -1);
+            for (int f = 0; f < count; ++f) {
+                p2t::smbFft(expected[f], N, -1);
+                EXPECT_NEAR_VEC_EPS(frames[f], expected[f], 1e-4f);
+            }
+        }
+    }
+}
+
+TEST(FftBatchTest, RealBatchRoundTrip) {
+    const int N = 128;
+    const int count = 11;
+    std::vector<std::vector<float> > frames(count, std::vector<float>(N + 2, 0.0f));
+    std::vector<float *> pointers;
+    for (int f = 0; f < count; ++f) {
+        for (int i = 0; i < N; ++i) frames[f][i] = std::cos(0.07f * i * (f + 1));
+        pointers.push_back(frames[f].data());
+    }
+    const auto original = frames;
+
+    const p2t::RealFftPlan plan(N);
+    plan.forwardBatch(pointers.data(), count);
+
+    for (int f = 0; f < count; ++f) {
+        std::vector<float> single = original[f];
+        plan.forward(single.data());
+        EXPECT_NEAR_VEC_EPS(frames[f], single, 1e-4f);
+    }
+
+    plan.inverseBatch(pointers.data(), count);
+    for (int f = 0; f < count; ++f) {
+        for (int i = 0; i < N; ++i) {
+            EXPECT_NEAR(frames[f][i] / N, original[f][i], 1e-5f);
+        }
+    }
+}
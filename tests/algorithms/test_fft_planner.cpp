@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "pytotune/algorithms/fft.h"
+#include "pytotune/algorithms/fft_planner.h"
+#include "../test_utils.h"
+
+// Points the planner at a fresh wisdom file and restores the previous one afterwards
+class FftPlannerTest : public ::testing::Test {
+protected:
+    const std::string wisdomPath = constants::TEST_OUTPUT_DIR + "/fft_wisdom.txt";
+
+    void SetUp() override {
+        previousPath = p2t::getFftWisdomPath();
+        std::remove(wisdomPath.c_str());
+        p2t::setFftWisdomPath(wisdomPath);
+    }
+
+    void TearDown() override {
+        std::remove(wisdomPath.c_str());
+        p2t::setFftWisdomPath(previousPath);
+    }
+
+private:
+    std::string previousPath;
+};
+
+TEST_F(FftPlannerTest, TuneStoresAndReloadsWisdom) {
+    EXPECT_FALSE(p2t::fftWisdom(256).has_value());
+
+    p2t::tuneFft({256, 96});
+    const auto kernel256 = p2t::fftWisdom(256);
+    const auto kernel96 = p2t::fftWisdom(96);
+    ASSERT_TRUE(kernel256.has_value());
+    ASSERT_TRUE(kernel96.has_value());
+    EXPECT_TRUE(*kernel96 == p2t::FftKernel::MixedRadix || *kernel96 == p2t::FftKernel::Bluestein);
+
+    // A later process only reads the file
+    p2t::setFftWisdomPath("");
+    EXPECT_FALSE(p2t::fftWisdom(256).has_value());
+    p2t::setFftWisdomPath(wisdomPath);
+    EXPECT_EQ(p2t::fftWisdom(256), kernel256);
+    EXPECT_EQ(p2t::fftWisdom(96), kernel96);
+}
+
+TEST_F(FftPlannerTest, KeepsWisdomOfOtherMachines) {
+    {
+        std::ofstream file(wisdomPath);
+        file << "Some Other CPU hwy=on\t512\tradix4\n";
+        file << "malformed line\n";
+    }
+    p2t::setFftWisdomPath(wisdomPath);
+    EXPECT_FALSE(p2t::fftWisdom(512).has_value());
+
+    p2t::tuneFft({64});
+
+    std::ifstream file(wisdomPath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "Some Other CPU hwy=on\t512\tradix4");
+    EXPECT_NE(lines[1].find("\t64\t"), std::string::npos);
+}
+
+TEST_F(FftPlannerTest, StoreMergesEntriesWrittenMeanwhile) {
+    p2t::tuneFft({64});
+    {
+        // Another process adds wisdom after this one loaded the file
+        std::ofstream file(wisdomPath, std::ios::app);
+        file << "Some Other CPU hwy=on\t512\tradix4\n";
+    }
+    p2t::tuneFft({128});
+
+    std::ifstream file(wisdomPath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "Some Other CPU hwy=on\t512\tradix4");
+    EXPECT_NE(lines[1].find("\t64\t"), std::string::npos);
+    EXPECT_NE(lines[2].find("\t128\t"), std::string::npos);
+
+    // No temporary file is left next to the wisdom
+    const auto directory = std::filesystem::path(wisdomPath).parent_path();
+    const auto prefix = std::filesystem::path(wisdomPath).filename().string() + ".";
+    for (const auto &entry: std::filesystem::directory_iterator(directory)) {
+        EXPECT_NE(entry.path().filename().string().rfind(prefix, 0), 0u) << entry.path();
+    }
+}
+
+TEST_F(FftPlannerTest, AutoPlansUseDefaultKernelWithoutWisdom) {
+    const p2t::FftPlan plan(128, p2t::FftKernel::Auto);
+    EXPECT_EQ(plan.kernel(), p2t::DEFAULT_FFT_KERNEL);
+    EXPECT_FALSE(p2t::fftWisdom(128).has_value());
+    EXPECT_FALSE(std::filesystem::exists(wisdomPath));
+
+    EXPECT_EQ(p2t::FftPlan(96, p2t::FftKernel::Auto).kernel(), p2t::FftKernel::MixedRadix);
+}
+
+TEST_F(FftPlannerTest, AutoPlansUseTunedKernel) {
+    const int N = 128;
+    p2t::tuneFft({N});
+    const p2t::FftPlan plan(N, p2t::FftKernel::Auto);
+    ASSERT_TRUE(p2t::fftWisdom(N).has_value());
+    EXPECT_EQ(plan.kernel(), *p2t::fftWisdom(N));
+
+    std::vector<float> a(2 * N);
+    for (int i = 0; i < 2 * N; ++i) a[i] = std::sin(0.37f * i);
+    std::vector<float> b = a;
+    plan.execute(a.data(), -1);
+    p2t::FftPlan(N, p2t::FftKernel::Radix2).execute(b.data(), -1);
+    EXPECT_NEAR_VEC_EPS(a, b, 1e-3f);
+}
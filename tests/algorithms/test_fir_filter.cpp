@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "pytotune/algorithms/fir_filter.h"
+
+namespace {
+    std::vector<float> noise(const int size, const unsigned int seed) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        std::vector<float> samples(size);
+        for (auto &x: samples) x = distribution(random);
+        return samples;
+    }
+
+    /// output[m] = sum_k kernel[k] * input[m * factor + delay - k] in double precision.
+    std::vector<double> referenceFilter(const std::vector<float> &input, const std::vector<float> &kernel,
+                                        const int factor, const int delay) {
+        std::vector<double> output(input.size() / factor);
+        for (size_t m = 0; m < output.size(); ++m) {
+            for (size_t k = 0; k < kernel.size(); ++k) {
+                const long index = static_cast<long>(m * factor) + delay - static_cast<long>(k);
+                if (index >= 0 && index < static_cast<long>(input.size())) output[m] += kernel[k] * input[index];
+            }
+        }
+        return output;
+    }
+}
+
+TEST(FirFilterTest, MatchesDirectConvolution) {
+    const auto input = noise(5000, 1);
+    for (const auto method: {p2t::FirMethod::Direct, p2t::FirMethod::OverlapSave}) {
+        for (const int taps: {1, 7, 101, 201, 513}) {
+            for (const int factor: {1, 2, 3, 4, 8}) {
+                for (const int delay: {0, taps / 2, taps - 1}) {
+                    const auto kernel = noise(taps, taps + factor);
+                    const p2t::FirFilter filter(kernel, factor, method);
+                    const auto output = filter.apply(input, delay);
+                    const auto expected = referenceFilter(input, kernel, factor, delay);
+
+                    SCOPED_TRACE("method=" + std::to_string(static_cast<int>(method)) + " taps=" +
+                                 std::to_string(taps) + " factor=" + std::to_string(factor) + " delay=" +
+                                 std::to_string(delay));
+                    ASSERT_EQ(output.size(), expected.size());
+                    for (size_t m = 0; m < output.size(); ++m) {
+                        ASSERT_NEAR(output[m], expected[m], 1e-3 * std::sqrt(static_cast<double>(taps))) << "m=" << m;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(FirFilterTest, AutoChoosesByTapsPerBranch) {
+    EXPECT_EQ(p2t::FirFilter(std::vector<float>(101, 1.f)).method(), p2t::FirMethod::OverlapSave);
+    EXPECT_EQ(p2t::FirFilter(std::vector<float>(201, 1.f), 4).method(), p2t::FirMethod::OverlapSave);
+    EXPECT_EQ(p2t::FirFilter(std::vector<float>(64, 1.f), 4).method(), p2t::FirMethod::Direct);
+    EXPECT_EQ(p2t::FirFilter(std::vector<float>(15, 1.f)).method(), p2t::FirMethod::Direct);
+    EXPECT_EQ(p2t::FirFilter(std::vector<float>(15, 1.f)).fftSize(), 0);
+
+    const p2t::FirFilter longFilter(std::vector<float>(1000, 1.f), 2);
+    EXPECT_EQ(longFilter.method(), p2t::FirMethod::OverlapSave);
+    EXPECT_GE(longFilter.fftSize(), 2 * 500);
+}
+
+TEST(FirFilterTest, ShortInputGivesEmptyOutput) {
+    const p2t::FirFilter filter(std::vector<float>(31, 1.f), 4);
+    EXPECT_TRUE(filter.apply({}).empty());
+    EXPECT_TRUE(filter.apply({1.f, 2.f, 3.f}).empty());
+    EXPECT_EQ(filter.apply({1.f, 2.f, 3.f, 4.f}).size(), 1u);
+}
+
+TEST(FirFilterTest, RejectsInvalidArguments) {
+    EXPECT_THROW(p2t::FirFilter({}), std::invalid_argument);
+    EXPECT_THROW(p2t::FirFilter({1.f}, 0), std::invalid_argument);
+}
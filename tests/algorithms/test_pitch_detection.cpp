@@ -51,6 +51,30 @@ TEST(PitchDetectionTest, DetectSineWavePitchWithOverlap) {
         });
 }
 
+TEST(PitchDetectionTest, DecimationOfUnevenLengths) {
+    // Lengths that are no multiple of the factor once wrote ceil(size / factor) decimated samples into size / factor
+    const int stride = 512;
+    const p2t::YINPitchDetector detector({2048, stride});
+    for (const int length: {44101, 44103, 44105, 44107}) {
+        p2t::WavData data;
+        data.sampleRate = 44100;
+        data.numChannels = 1;
+        data.samples.resize(length);
+        for (int i = 0; i < length; ++i) {
+            data.samples[i] = 0.5f * std::sin(2.f * static_cast<float>(M_PI) * 440.f * static_cast<float>(i) / 44100.f);
+        }
+
+        for (const int factor: {2, 3, 4, 5, 6, 7, 8}) {
+            SCOPED_TRACE("length=" + std::to_string(length) + " factor=" + std::to_string(factor));
+            const auto detection = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, factor);
+            ASSERT_EQ(detection.data.size(), static_cast<size_t>(length / stride));
+            for (size_t i = 4; i + 8 < detection.data.size(); ++i) {
+                EXPECT_NEAR(detection.data[i], 440.f, 5.f) << "i=" << i;
+            }
+        }
+    }
+}
+
 TEST(PitchDetectionTest, DetectPianoPitch) {
     std::string testFile = constants::PIANO_F220_SR44100;
 
@@ -94,3 +118,170 @@ TEST(PitchDetectionTest, DetectVoicePitch) {
         }
         });
 }
+
+TEST(PitchDetectionTest, DifferenceMethodsAgree) {
+    const p2t::WavFile reader = p2t::WavFile::load(constants::PIANO_F220_SR44100);
+    const auto &data = reader.data();
+    const p2t::YINPitchDetector detector({2048, 512});
+
+    // Narrow and wide tau ranges, with and without decimation
+    for (const auto range: {p2t::VoiceRanges::HUMAN, p2t::VoiceRanges::PIANO}) {
+        for (const int decimation: {1, 4}) {
+            const auto direct = detector.detectPitch(data, range, 0.05f, decimation, p2t::DifferenceMethod::Direct);
+            const auto fft = detector.detectPitch(data, range, 0.05f, decimation, p2t::DifferenceMethod::Fft);
+            const auto incremental = detector.detectPitch(data, range, 0.05f, decimation,
+                                                          p2t::DifferenceMethod::Incremental);
+            const auto automatic = detector.detectPitch(data, range, 0.05f, decimation, p2t::DifferenceMethod::Auto);
+
+            SCOPED_TRACE("min=" + std::to_string(range.min) + " d=" + std::to_string(decimation));
+            EXPECT_NEAR_VEC_EPS(fft.data, direct.data, 0.05f);
+            EXPECT_NEAR_VEC_EPS(incremental.data, direct.data, 0.05f);
+            EXPECT_NEAR_VEC_EPS(automatic.data, direct.data, 0.05f);
+        }
+    }
+}
+
+TEST(PitchDetectionTest, CoarseToFineKeepsFullRateAccuracy) {
+    const p2t::YINPitchDetector detector({2048, 512});
+    for (const auto &file: {constants::SIN_F440_I80_SR44100_AF1, constants::STRINGS_F440_SR44100}) {
+        const p2t::WavFile reader = p2t::WavFile::load(file);
+        const auto &data = reader.data();
+        const auto fullRate = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, 1);
+
+        for (const int decimation: {2, 4, 8}) {
+            const auto coarseToFine = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, decimation,
+                                                           p2t::DifferenceMethod::Auto,
+                                                           p2t::SearchMode::CoarseToFine);
+
+            SCOPED_TRACE(file + " d=" + std::to_string(decimation));
+            ASSERT_EQ(coarseToFine.data.size(), fullRate.data.size());
+            // Within a cent of the full-rate search
+            EXPECT_NEAR_VEC_EPS(coarseToFine.data, fullRate.data, 0.25f);
+        }
+    }
+}
+
+TEST(PitchDetectionTest, TrackingMatchesFullSearch) {
+    const p2t::YINPitchDetector detector({2048, 512});
+    // Sustained notes and a glide, which the tau band around the previous period has to follow
+    for (const auto &file: {constants::VOICE_F400_SR4100, constants::STRINGS_F440_SR44100,
+                            constants::SIN_RAISE_FSTART200_FEND1000_I80_SR44100_AF1}) {
+        const p2t::WavFile reader = p2t::WavFile::load(file);
+        const auto &data = reader.data();
+
+        for (const int decimation: {1, 4}) {
+            const auto full = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, decimation);
+            const auto tracked = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, decimation,
+                                                      p2t::DifferenceMethod::Auto, p2t::SearchMode::Tracking);
+
+            SCOPED_TRACE(file + " d=" + std::to_string(decimation));
+            ASSERT_EQ(tracked.data.size(), full.data.size());
+            EXPECT_NEAR_VEC_EPS(tracked.data, full.data, 0.05f);
+        }
+    }
+}
+
+TEST(PitchDetectionTest, TrackingFindsDipsBelowThePreviousPeriod) {
+    // A 220 Hz sine, then 660 Hz over a weak 220 Hz: the first CMND dip moves to a third of the
+    // previous period, while the previous period itself stays a dip below the threshold
+    p2t::WavData data;
+    data.sampleRate = 44100;
+    data.numChannels = 1;
+    data.samples.resize(2 * 44100);
+    for (int i = 0; i < 2 * 44100; ++i) {
+        const double t = static_cast<double>(i) / 44100.0;
+        data.samples[i] = static_cast<float>(i < 44100
+                                                 ? 0.5 * std::sin(2.0 * M_PI * 220.0 * t)
+                                                 : 0.5 * std::sin(2.0 * M_PI * 660.0 * t) +
+                                                   0.05 * std::sin(2.0 * M_PI * 220.0 * t));
+    }
+
+    const int stride = 512;
+    const p2t::YINPitchDetector detector({2048, stride});
+    for (const auto method: {p2t::DifferenceMethod::Direct, p2t::DifferenceMethod::Fft}) {
+        const auto full = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, 1, method);
+        const auto tracked = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, 1, method,
+                                                  p2t::SearchMode::Tracking);
+
+        SCOPED_TRACE("method=" + std::to_string(static_cast<int>(method)));
+        ASSERT_EQ(tracked.data.size(), full.data.size());
+        EXPECT_NEAR_VEC_EPS(tracked.data, full.data, 0.05f);
+        for (int i = 44100 / stride + 8; i + 8 < 2 * 44100 / stride; ++i) {
+            EXPECT_NEAR(tracked.data[i], 660.f, 2.f) << "i=" << i;
+        }
+    }
+}
+
+TEST(PitchDetectionTest, SilentWindowsAreUnvoiced) {
+    // One second of a 440 Hz sine, one of silence, one of the sine again
+    p2t::WavData data;
+    data.sampleRate = 44100;
+    data.numChannels = 1;
+    data.samples.resize(3 * 44100);
+    for (int i = 0; i < 44100; ++i) {
+        const float sample = 0.5f * std::sin(2.f * static_cast<float>(M_PI) * 440.f * static_cast<float>(i) / 44100.f);
+        data.samples[i] = sample;
+        data.samples[2 * 44100 + i] = sample;
+    }
+
+    const int stride = 512;
+    const p2t::YINPitchDetector detector({2048, stride});
+    for (const auto method: {p2t::DifferenceMethod::Direct, p2t::DifferenceMethod::Fft,
+                             p2t::DifferenceMethod::Incremental}) {
+        for (const auto mode: {p2t::SearchMode::Decimated, p2t::SearchMode::Tracking}) {
+            const auto detection = detector.detectPitch(data, p2t::VoiceRanges::HUMAN, 0.1f, 1, method, mode);
+
+            SCOPED_TRACE("method=" + std::to_string(static_cast<int>(method)) + " mode=" +
+                         std::to_string(static_cast<int>(mode)));
+            // Keep clear of the windows overlapping both and of the median filter around them
+            for (int i = 44100 / stride + 3; i + 8 < 2 * 44100 / stride; ++i) {
+                EXPECT_EQ(detection.data[i], 0.f) << "i=" << i;
+            }
+            for (int i = 2 * 44100 / stride + 3; i + 8 < 3 * 44100 / stride; ++i) {
+                EXPECT_NEAR(detection.data[i], 440.f, 1.f) << "i=" << i;
+            }
+        }
+    }
+}
+
+TEST(PitchDetectionTest, DecimationMethodsShareThePassband) {
+    // Sines in the passband keep their amplitude and phase, sines that would alias are removed
+    for (const int factor: {2, 4, 8}) {
+        for (const float fraction: {0.1f, 0.5f, 0.7f, 1.5f, 1.9f}) {
+            const float frequency = fraction * 0.5f / static_cast<float>(factor);
+            std::vector<float> input(16384);
+            for (size_t i = 0; i < input.size(); ++i) {
+                // In double, so phase rounding at large indices does not raise a noise floor above the stopband
+                input[i] = static_cast<float>(std::sin(2.0 * M_PI * frequency * static_cast<double>(i)));
+            }
+
+            for (const auto method: {p2t::DecimationMethod::ZeroPhase, p2t::DecimationMethod::HalfbandCascade}) {
+                const auto output = p2t::YINPitchDetector::decimate(input, factor, method);
+                ASSERT_EQ(output.size(), input.size() / factor);
+
+                SCOPED_TRACE("factor=" + std::to_string(factor) + " fraction=" + std::to_string(fraction) +
+                             " method=" + std::to_string(static_cast<int>(method)));
+                // Skip the edges, where the filters run into the zero padding
+                float aliasPeak = 0.f;
+                for (size_t m = 128; m + 128 < output.size(); ++m) {
+                    const float expected = fraction < 1.f ? input[m * factor] : 0.f;
+                    ASSERT_NEAR(output[m], expected, 0.02f) << "m=" << m;
+                    aliasPeak = std::max(aliasPeak, std::abs(output[m]));
+                }
+                // Stopband: the cascade rejects as much as the forward-backward single stage
+                if (fraction > 1.f) {
+                    EXPECT_LT(20.f * std::log10(aliasPeak + 1e-12f), -DECIMATION_STOPBAND_DB);
+                }
+            }
+        }
+    }
+}
+
+TEST(PitchDetectionTest, HalfbandCascadeNeedsPowerOfTwo) {
+    const std::vector<float> input(1000, 1.f);
+    EXPECT_THROW(p2t::YINPitchDetector::decimate(input, 3, p2t::DecimationMethod::HalfbandCascade),
+                 std::invalid_argument);
+    // Auto falls back to a single stage
+    EXPECT_EQ(p2t::YINPitchDetector::decimate(input, 3, p2t::DecimationMethod::Auto).size(), 333u);
+    EXPECT_EQ(p2t::YINPitchDetector::decimate(input, 1), input);
+}
@@ -70,3 +70,29 @@ TEST(TestPitchShifter, ResultEqualsReferenceCode) {
     // newFile2.store(std::string(TEST_OUTPUT_DIR) + "test2.wav");
 }
 */
+
+TEST(TestPitchShifter, RejectsOddWindowSize) {
+    EXPECT_THROW(p2t::PitchShifter({1025, 256}, 44100.f), std::invalid_argument);
+}
+
+TEST(TestPitchShifter, NonPowerOfTwoWindowMatchesPowerOfTwoLevel) {
+    constexpr float sampleRate = 48000.f;
+    std::vector<float> samples(48000);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.5f * std::sin(2.f * static_cast<float>(M_PI) * 440.f * static_cast<float>(i) / sampleRate);
+    }
+
+    // 40 ms windows at 48 kHz next to the closest power of two
+    const auto out = p2t::PitchShifter({1920, 480}, sampleRate).run(samples, 1.0f);
+    const auto reference = p2t::PitchShifter({2048, 512}, sampleRate).run(samples, 1.0f);
+
+    ASSERT_EQ(out.size(), samples.size());
+    double energy = 0.0;
+    double referenceEnergy = 0.0;
+    for (size_t i = 2048; i + 2048 < samples.size(); ++i) {
+        ASSERT_TRUE(std::isfinite(out[i]));
+        energy += out[i] * out[i];
+        referenceEnergy += reference[i] * reference[i];
+    }
+    EXPECT_NEAR(energy / referenceEnergy, 1.0, 0.05);
+}
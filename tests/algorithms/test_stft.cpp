@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "pytotune/algorithms/stft.h"
+
+namespace {
+    std::vector<float> sine(const float frequency, const float sampleRate, const int size) {
+        std::vector<float> samples(size);
+        for (int i = 0; i < size; ++i) {
+            samples[i] = std::sin(2.f * static_cast<float>(M_PI) * frequency * static_cast<float>(i) / sampleRate);
+        }
+        return samples;
+    }
+}
+
+TEST(StftAnalyzerTest, FindsTrueFrequencyBetweenBins) {
+    constexpr float sampleRate = 44100.f;
+    const p2t::Windowing windowing(1024, 256);
+    const p2t::StftAnalyzer analyzer(windowing, sampleRate);
+    const float binWidth = sampleRate / 1024.f;
+    const float frequency = 20.3f * binWidth;
+    const auto samples = sine(frequency, sampleRate, 8192);
+
+    std::vector<std::vector<float> > frames(4, std::vector<float>(analyzer.frameSize()));
+    float *pointers[4];
+    for (int f = 0; f < 4; ++f) pointers[f] = frames[f].data();
+    analyzer.analyze(samples, 0, 4, pointers);
+
+    std::vector<float> lastPhase(analyzer.numBins(), 0.f);
+    for (int f = 0; f < 4; ++f) analyzer.trueFrequency(pointers[f], lastPhase.data());
+
+    // The loudest bin is the closest one, and its phase advance reveals the exact frequency
+    int peak = 0;
+    for (int k = 0; k < analyzer.numBins(); ++k) {
+        if (frames[3][2 * k] > frames[3][2 * peak]) peak = k;
+    }
+    EXPECT_EQ(peak, 20);
+    EXPECT_NEAR(frames[3][2 * peak + 1], frequency, 0.5f);
+    EXPECT_NEAR(frames[3][2 * (peak + 1) + 1], frequency, 0.5f);
+}
+
+TEST(StftAnalyzerTest, ZeroPadsPastEndOfInput) {
+    const p2t::Windowing windowing(256, 64);
+    const p2t::StftAnalyzer analyzer(windowing, 8000.f);
+    const std::vector<float> samples(300, 0.f);
+
+    std::vector<float> frame(analyzer.frameSize(), 1.f);
+    float *pointer = frame.data();
+    analyzer.analyze(samples, 3, 1, &pointer);
+
+    for (int k = 0; k < analyzer.numBins(); ++k) {
+        EXPECT_EQ(frame[2 * k], 0.f);
+    }
+}
+
+TEST(StftAnalyzerTest, RejectsOddWindowSize) {
+    EXPECT_THROW(p2t::StftAnalyzer(p2t::Windowing(255, 64), 8000.f), std::invalid_argument);
+}
+
+TEST(StftSynthesizerTest, AnalysisSynthesisRoundTrip) {
+    constexpr float sampleRate = 44100.f;
+    const p2t::Windowing windowing(1024, 256);
+    const p2t::StftAnalyzer analyzer(windowing, sampleRate);
+    const p2t::StftSynthesizer synthesizer(windowing);
+    const auto samples = sine(440.f, sampleRate, 8192);
+    const int numWindows = static_cast<int>(samples.size()) / windowing.stride;
+
+    std::vector<std::vector<float> > frames(numWindows, std::vector<float>(synthesizer.frameSize()));
+    std::vector<float *> pointers;
+    for (auto &frame: frames) pointers.push_back(frame.data());
+    analyzer.analyze(samples, 0, numWindows, pointers.data());
+    synthesizer.synthesize(pointers.data(), numWindows);
+
+    std::vector<float> output(samples.size(), 0.f);
+    for (int f = 0; f < numWindows; ++f) synthesizer.overlapAdd(frames[f].data(), f, output);
+
+    // Unmodified phases give the input back, with the usual phase vocoder gain of the
+    // doubled analysis magnitude and the summed Hann windows at osamp 4
+    for (size_t i = 1024; i < samples.size() - 1024; ++i) {
+        EXPECT_NEAR(output[i], 1.5f * samples[i], 1e-3f);
+    }
+}
+
+TEST(StftSynthesizerTest, OverlapAddStaysInsideOutput) {
+    const p2t::Windowing windowing(256, 64);
+    const p2t::StftSynthesizer synthesizer(windowing);
+    EXPECT_EQ(synthesizer.overlapFrames(), 4);
+
+    const std::vector<float> frame(synthesizer.frameSize(), 1.f);
+    std::vector<float> output(300, 0.f);
+    synthesizer.overlapAdd(frame.data(), 3, std::span(output).first(250));
+    synthesizer.overlapAdd(frame.data(), 10, output);
+
+    for (size_t i = 0; i < output.size(); ++i) {
+        if (i <= 192 || i >= 250) {
+            EXPECT_EQ(output[i], 0.f);
+        } else {
+            EXPECT_GT(output[i], 0.f);
+        }
+    }
+}
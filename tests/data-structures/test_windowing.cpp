@@ -33,3 +33,17 @@ TEST(WindowingTest, TestFromLambdaCreation) {
     EXPECT_EQ(wd.windowing.stride, 10);
     EXPECT_EQ(wd.data, (std::vector<float>({0.f, 25.f, 100.f, 225.f, 400.f})));
 }
+
+TEST(WindowingTest, TestValidateForFft) {
+    EXPECT_NO_THROW(p2t::Windowing(4096, 1024).validateForFft());
+    EXPECT_NO_THROW(p2t::Windowing(1920, 480).validateForFft());
+    EXPECT_NO_THROW(p2t::Windowing(2880, 0.75f).validateForFft());
+
+    EXPECT_THROW(p2t::Windowing(0, 1).validateForFft(), std::invalid_argument);
+    EXPECT_THROW(p2t::Windowing(1921, 480).validateForFft(), std::invalid_argument);
+    EXPECT_THROW(p2t::Windowing(1920, 0).validateForFft(), std::invalid_argument);
+    EXPECT_THROW(p2t::Windowing(1920, 1921).validateForFft(), std::invalid_argument);
+    // Strides that do not divide the window size
+    EXPECT_THROW(p2t::Windowing(1000, 300).validateForFft(), std::invalid_argument);
+    EXPECT_THROW(p2t::Windowing(2048, 2048 - 500).validateForFft(), std::invalid_argument);
+}
@@ -0,0 +1,16 @@
+#include <gtest/gtest.h>
+
+#include "pytotune/algorithms/fft_planner.h"
+#include "test_utils.h"
+
+namespace {
+    // Plans built with FftKernel::Auto read wisdom, so no test may depend on or touch the user's wisdom file
+    class FftWisdomEnvironment : public ::testing::Environment {
+    public:
+        void SetUp() override {
+            p2t::setFftWisdomPath(constants::TEST_OUTPUT_DIR + "/fft_wisdom_tests.txt");
+        }
+    };
+
+    const auto *fftWisdomEnvironment = ::testing::AddGlobalTestEnvironment(new FftWisdomEnvironment);
+}